@@ -1,5 +1,7 @@
 #version 330 core
 
+// Members are ordered so the std140 layout has no holes beyond the struct tails.
+// LightBuffer (Game/Header/LightBuffer.h) mirrors these structs byte for byte.
 struct DirLight {
     vec3  direction;
     vec4  ambient;
@@ -9,22 +11,22 @@ struct DirLight {
 
 struct PointLight {
     vec3  position;
+    float constant;
     vec4  ambient;
     vec4  diffuse;
     vec4  specular;
-    float constant;
     float linear;
     float quadratic;
 };
 
 struct SpotLight {
     vec3  position;
+    float constant;
     vec3  direction;
+    float linear;
     vec4  ambient;
     vec4  diffuse;
     vec4  specular;
-    float constant;
-    float linear;
     float quadratic;
     float cutOff;
     float outerCutOff;
@@ -34,14 +36,14 @@ struct SpotLight {
 #define MAX_POINT  30
 #define MAX_SPOT   10
 
-uniform int        numDir;
-uniform DirLight   dirLights[MAX_DIR];
-
-uniform int        numPoint;
-uniform PointLight pointLights[MAX_POINT];
-
-uniform int        numSpot;
-uniform SpotLight  spotLights[MAX_SPOT];
+layout(std140) uniform Lights {
+    int        numDir;
+    int        numPoint;
+    int        numSpot;
+    DirLight   dirLights[MAX_DIR];
+    PointLight pointLights[MAX_POINT];
+    SpotLight  spotLights[MAX_SPOT];
+};
 
 in vec3 FragPos;
 in vec3 Normal;
@@ -57,6 +59,22 @@ uniform float uMatShininess;
 uniform sampler2D u_Texture;
 uniform float u_opacity;
 
+// Small textures live in tiles of a texture array; uAtlasLayer -1 samples u_Texture instead
+uniform sampler2DArray u_Atlas;
+uniform int   uAtlasLayer;
+uniform vec4  uAtlasRegion;     // Tile scale (xy) and offset (zw)
+
+vec4 SampleTexture()
+{
+    if (uAtlasLayer < 0)
+        return texture(u_Texture, UV);
+
+    // Repeat inside the tile; the gradients come from the unwrapped UVs so the wrap seam keeps its mip level
+    vec2 scale = uAtlasRegion.xy;
+    vec2 uv    = uAtlasRegion.zw + fract(UV) * scale;
+    return textureGrad(u_Atlas, vec3(uv, float(uAtlasLayer)), dFdx(UV) * scale, dFdy(UV) * scale);
+}
+
 vec4 CalcDirLight(DirLight light, vec3 N, vec3 V, vec4 texColor)
 {
     vec3 L = normalize(light.direction);
@@ -115,7 +133,7 @@ void main()
 {
     vec3 V = normalize(uViewPos - FragPos);
 
-    vec4 texColor = texture(u_Texture, UV) * uMatDiffuse;
+    vec4 texColor = SampleTexture() * uMatDiffuse;
 
     vec4 color = vec4(0.0);
 
@@ -1,12 +1,33 @@
 #version 330 core
 
 layout(location = 0) in vec3 aPosition;
+#ifdef COMPRESSED_VERTICES
+// Octahedral normal (snorm16 x2), position in [0,1] over the model bounds (unorm16)
+layout(location = 1) in vec2 aNormal;
+#else
 layout(location = 1) in vec3 aNormal;
+#endif
 layout(location = 2) in vec2 aUV;
 
-uniform mat4 uMVP;
-uniform mat4 uModel;
-uniform mat4 uNormalMatrix;
+// Per-instance data (InstanceData in Model.h), one draw covers every mesh of a group
+layout(location = 3) in mat4 aModel;
+layout(location = 7) in mat3 aNormalMatrix;
+
+uniform mat4 uViewProj;
+
+#ifdef COMPRESSED_VERTICES
+uniform vec3 uPositionScale;
+uniform vec3 uPositionOffset;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -14,12 +35,16 @@ out vec2 UV;
 
 void main()
 {
-    // world‐space position
-    FragPos = vec3(uModel * vec4(aPosition, 1.0));
-    // transform normal via the full 4×4 inverse‐transpose, treating it as a direction
-    Normal  = normalize((uNormalMatrix * vec4(aNormal, 0.0)).xyz);
-    // pass through UVs
-    UV      = aUV;
-    // finally, clip‐space position
-    gl_Position = uMVP * vec4(aPosition, 1.0);
+#ifdef COMPRESSED_VERTICES
+    vec3 position = aPosition * uPositionScale + uPositionOffset;
+    vec3 normal   = octDecode(aNormal);
+#else
+    vec3 position = aPosition;
+    vec3 normal   = aNormal;
+#endif
+    vec4 world  = aModel * vec4(position, 1.0);
+    FragPos     = world.xyz;
+    Normal      = normalize(aNormalMatrix * normal);
+    UV          = aUV;
+    gl_Position = uViewProj * world;
 }
\ No newline at end of file
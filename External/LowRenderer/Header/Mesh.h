@@ -3,6 +3,7 @@
 #include "Model.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "MaterialInstance.h"
 #include "LibMath/Matrix/Matrix4.h"
 #include <string>
 #include <vector>
@@ -12,6 +13,8 @@
 #include "LibMath/Angle.h"
 #include "Mesh.h"
 #include"ResourceManager.h"
+#include "AssetLoader.h"
+#include "LevelData.h"
 
 
 
@@ -27,16 +30,77 @@ public:
         m_texture = texture;
     }
 
-    // Set the mesh’s model‐to‐world transform
-    void    setModelMatrix(const LibMath::Matrix4& m) { m_modelMatrix = m; }
+    // Use a material instance: its (shared) texture and its per-use parameters
+    void    setMaterial(const MaterialInstance* material)
+    {
+        m_texture = material ? material->getTexture() : nullptr;
+        m_opacity = material ? material->getOpacity() : 1.0f;
+    }
+    void    setOpacity(float opacity) { m_opacity = opacity; }
+    float   getOpacity() const { return m_opacity; }
+
+    // Set the mesh’s model‐to‐world transform (and the normal matrix that goes with it)
+    void    setModelMatrix(const LibMath::Matrix4& m)
+    {
+        m_modelMatrix = m;
+        m_normalMatrix = m.inverse().transpose();
+    }
+
+    // World-space bounds computed offline (compiled levels), colliders use them instead of the vertices
+    void    setWorldBounds(const LibMath::Prism3DAABB& bounds) { m_worldBounds = bounds; m_hasWorldBounds = true; }
+    bool    hasWorldBounds() const { return m_hasWorldBounds; }
+    const LibMath::Prism3DAABB& getWorldBounds() const { return m_worldBounds; }
+
+    // Uniforms a mesh sets, resolved once per shader (the matrices are per-instance attributes)
+    struct Uniforms
+    {
+        UniformHandle   m_viewProj;
+        UniformHandle   m_texture;
+        UniformHandle   m_atlas;
+        UniformHandle   m_atlasLayer;       // -1 samples m_texture
+        UniformHandle   m_atlasRegion;      // Tile scale (xy) and offset (zw)
+        UniformHandle   m_opacity;
+        UniformHandle   m_positionScale;    // Compressed vertices only
+        UniformHandle   m_positionOffset;
+
+        static Uniforms resolve(const Shader& shader);
+    };
+
+    // Texture units: the mesh's own texture, and the atlas array bound once for the whole pass
+    static constexpr GLint k_textureUnit = 0;
+    static constexpr GLint k_atlasUnit = 1;
+
+    // Texture bound on k_textureUnit during a pass, so meshes sharing a texture (or drawing from the atlas) skip the bind
+    struct DrawState
+    {
+        GLuint  m_boundTexture = 0;
+        bool    m_hasBinding = false;
+        size_t  m_bindCount = 0;
+    };
 
-    // Draw with this shader and precomputed VP matrix
-    void    draw(Shader* shader, const LibMath::Matrix4& viewProj) const;
+    // Meshes are drawn by MeshBatcher, a group of instances at a time.
+    // Set what every instance of a group shares: texture (or atlas tile), opacity, vertex dequantization
+    void    bindMaterial(const Shader& shader, const Uniforms& uniforms, DrawState& state) const;
+    // Per-instance data of this mesh for Model::drawInstanced
+    void    writeInstance(InstanceData& out) const;
+
+    // Pick the coarsest LOD of the model whose error, projected on screen, stays under k_lodPixelError.
+    // projectionScale is the viewport height in pixels times projection[1][1] / 2 (pixels per unit at distance 1).
+    // Going coarser needs the error to be well under the limit, so a mesh at the boundary does not flicker.
+    void    selectLod(const LibMath::Vector3& cameraPosition, float projectionScale);
+    size_t  getLod() const { return m_lod; }
+
+    // Centre of the model's bounding sphere in world space
+    LibMath::Vector3 getWorldCenter() const;
+
+    static constexpr float k_lodPixelError = 1.0f;
+    static constexpr float k_lodHysteresis = 0.7f;
 
     // Get the model this mesh is based on
     Model*  getModel() const { return m_model; }
     // Get the model matrix
     const LibMath::Matrix4& getModelMatrix() const { return m_modelMatrix; }
+    const LibMath::Matrix4& getNormalMatrix() const { return m_normalMatrix; }
     // Get the texture used by this mesh
     Texture* getTexture() const { return m_texture; }
 
@@ -77,14 +141,34 @@ public:
     /// }
     /// // else: levelMeshes now holds one Mesh* per line in cubeLayout.txt
     /// ```
+    ///
+    /// If `loader` is given, each referenced Model is waited on (through the loader,
+    /// which keeps running GPU uploads meanwhile) right before it is first used.
     static bool loadInstances(
         const std::string& transformFilePath,
         std::unordered_multimap<int, Mesh*>& outMeshes,
-        ResourceManager& manager
+        ResourceManager& manager,
+        AssetLoader* loader = nullptr
+    );
+
+    /// Same, from a level already parsed or mapped from a compiled .slvl.
+    /// Models and materials are looked up once per name-table entry, then each object costs one Mesh
+    /// built from its stored matrix. Stored world bounds are kept unless the model's bounds no longer
+    /// match the ones the level was compiled against.
+    static bool loadInstances(
+        const LevelData& level,
+        std::unordered_multimap<int, Mesh*>& outMeshes,
+        ResourceManager& manager,
+        AssetLoader* loader = nullptr
     );
 
 private:
-    Model*              m_model;
-    Texture*            m_texture;
-    LibMath::Matrix4    m_modelMatrix;
+    ResourceRef<Model>      m_model;        // Counted: a mesh keeps its model and texture resident
+    ResourceRef<Texture>    m_texture;
+    float                   m_opacity = 1.0f;
+    LibMath::Matrix4        m_modelMatrix;
+    LibMath::Matrix4        m_normalMatrix;     // Inverse-transpose of m_modelMatrix
+    LibMath::Prism3DAABB    m_worldBounds;
+    bool                    m_hasWorldBounds = false;
+    size_t                  m_lod = 0;
 };
\ No newline at end of file
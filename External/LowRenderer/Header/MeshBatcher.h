@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Mesh.h"
+#include <vector>
+
+// Collects the meshes of a pass, in draw order, and draws every run of consecutive meshes sharing a model,
+// LOD and material (texture and opacity) with one glDrawElementsInstanced. RenderQueue's sort puts the
+// meshes of a group next to each other. The matrices of all the runs go into one instance buffer,
+// sent once per flush. Draws need a shader reading them as instance attributes (LightsVert.glsl).
+class MeshBatcher
+{
+public:
+    MeshBatcher() = default;
+    ~MeshBatcher();
+    MeshBatcher(const MeshBatcher&) = delete;
+    MeshBatcher& operator=(const MeshBatcher&) = delete;
+
+    void    add(const Mesh* mesh) { m_meshes.push_back(mesh); }
+
+    // Draw the meshes added since the last flush with this shader (in use) and its resolved uniforms.
+    // Instances are drawn in the order they were added, so blended passes stay ordered.
+    void    flush(const Shader& shader, const Mesh::Uniforms& uniforms, const LibMath::Matrix4& viewProj,
+                  Mesh::DrawState& state);
+
+    // Since the last resetStats()
+    size_t  getDrawCount() const { return m_drawCount; }
+    size_t  getInstanceCount() const { return m_instanceCount; }
+    void    resetStats() { m_drawCount = 0; m_instanceCount = 0; }
+
+private:
+    static bool sameGroup(const Mesh& a, const Mesh& b);
+
+    std::vector<const Mesh*>    m_meshes;       // Kept between flushes, only cleared
+    std::vector<InstanceData>   m_instances;
+    GLuint                      m_buffer = 0;
+    size_t                      m_capacity = 0; // Bytes allocated for m_buffer
+    size_t                      m_drawCount = 0;
+    size_t                      m_instanceCount = 0;
+};
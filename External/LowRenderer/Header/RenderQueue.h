@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// The draws of a frame, each with a 64-bit key that puts them in submission order once sorted.
+//
+//   Opaque:       pass | shader | material | model | LOD | depth      (state changes first, then front to back)
+//   Transparent:  pass | ~depth | shader | material | model | LOD     (back to front, for blending)
+//
+// Materials (texture and opacity) and models get small ids the first time they are seen; past the
+// width of their field ids wrap, which only costs some state changes. Depth is the distance along the
+// view direction, as the top bits of its float (positive floats order like their bits).
+// Buffers are kept between frames, clear() only resets their size.
+class RenderQueue
+{
+public:
+    enum class Pass : uint8_t { Opaque = 0, Transparent = 1 };
+
+    struct Item
+    {
+        uint64_t        m_key;
+        const Mesh*     m_mesh;
+        Pass            m_pass;
+    };
+
+    static constexpr int k_shaderBits = 8;
+    static constexpr int k_materialBits = 12;
+    static constexpr int k_modelBits = 12;
+    static constexpr int k_lodBits = 2;
+    static constexpr int k_depthBits = 28;
+    static_assert(2 + k_shaderBits + k_materialBits + k_modelBits + k_lodBits + k_depthBits == 64, "Sort key fields must fill 64 bits");
+
+    void                    clear() { m_items.clear(); }
+    // Queue a mesh drawn by the shader with this id, depth along the view direction
+    void                    submit(const Mesh* mesh, Pass pass, uint32_t shader, float depth);
+    // LSD radix sort on the keys, 8 bits per pass; bytes every key shares are skipped
+    void                    sort();
+
+    std::span<const Item>   getItems() const { return m_items; }
+
+private:
+    uint32_t                materialId(const Mesh& mesh);
+    uint32_t                modelId(const Mesh& mesh);
+
+    std::vector<Item>                               m_items;
+    std::vector<Item>                               m_scratch;
+    std::unordered_map<uint64_t, uint32_t>          m_materialIds;  // Texture id and opacity bits
+    std::unordered_map<const void*, uint32_t>       m_objectIds;    // Textures and models
+};
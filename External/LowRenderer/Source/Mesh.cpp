@@ -1,155 +1,194 @@
 ﻿#include"Mesh.h"
+#include "LevelData.h"
+#include <cstring>
 
 
 Mesh::Mesh(Model* model, Texture* texture)
     : m_model(model)
     , m_texture(texture)
     , m_modelMatrix(LibMath::Matrix4::identity())
+    , m_normalMatrix(LibMath::Matrix4::identity())
 {}
 
 
-void Mesh::draw(Shader* shader, const LibMath::Matrix4& viewProj) const
+Mesh::Uniforms Mesh::Uniforms::resolve(const Shader& shader)
 {
-    // 1) Activate shader
-    shader->use();
+    Uniforms uniforms;
+    uniforms.m_viewProj     = shader.uniform("uViewProj");
+    uniforms.m_texture      = shader.uniform("u_Texture");
+    uniforms.m_atlas        = shader.uniform("u_Atlas");
+    uniforms.m_atlasLayer   = shader.uniform("uAtlasLayer");
+    uniforms.m_atlasRegion  = shader.uniform("uAtlasRegion");
+    uniforms.m_opacity      = shader.uniform("u_opacity");
+    uniforms.m_positionScale  = shader.uniform("uPositionScale");
+    uniforms.m_positionOffset = shader.uniform("uPositionOffset");
+    return uniforms;
+}
 
-    // 2) Bind the mesh�s texture (or a default white if nullptr)
-    glActiveTexture(GL_TEXTURE0);
-    if (m_texture) {
-        glBindTexture(GL_TEXTURE_2D, m_texture->getID());
+void Mesh::bindMaterial(const Shader& shader, const Uniforms& uniforms, DrawState& state) const
+{
+    // An atlas tile only needs its region, any other texture (or none if nullptr) is bound unless it already is
+    if (m_texture && m_texture->isAtlased()) {
+        const AtlasRegion& region = m_texture->getAtlasRegion();
+        shader.set(uniforms.m_atlasRegion, LibMath::Vector4(region.m_scale[0], region.m_scale[1], region.m_offset[0], region.m_offset[1]));
+        shader.set(uniforms.m_atlasLayer, region.m_layer);
     }
     else {
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLuint id = m_texture ? m_texture->getID() : 0;
+        if (!state.m_hasBinding || state.m_boundTexture != id) {
+            glActiveTexture(GL_TEXTURE0 + k_textureUnit);
+            glBindTexture(GL_TEXTURE_2D, id);
+            state.m_boundTexture = id;
+            state.m_hasBinding = true;
+            ++state.m_bindCount;
+        }
+        shader.set(uniforms.m_atlasLayer, -1);
     }
-    // Tell the shader which texture unit �u_Texture� lives on:
-    glUniform1i(
-        glGetUniformLocation(shader->getID(), "u_Texture"),
-        0
-    );
+    shader.set(uniforms.m_texture, k_textureUnit);
+    shader.set(uniforms.m_atlas, k_atlasUnit);
 
-    shader->setInt("u_Texture", 0);
+    shader.set(uniforms.m_opacity, m_opacity);
 
-    // 3) Compute & upload matrices
-    auto mvp = viewProj * m_modelMatrix;
-    GLint locMVP = glGetUniformLocation(shader->getID(), "uMVP");
-    glUniformMatrix4fv(locMVP, 1, GL_FALSE, mvp.getData());
+    // Dequantization of compressed positions (absent from the float shader variant)
+    shader.set(uniforms.m_positionScale, m_model->getPositionScale());
+    shader.set(uniforms.m_positionOffset, m_model->getPositionOffset());
+}
 
-    GLint locModel = glGetUniformLocation(shader->getID(), "uModel");
-    glUniformMatrix4fv(locModel, 1, GL_FALSE, m_modelMatrix.getData());
+void Mesh::writeInstance(InstanceData& out) const
+{
+    std::memcpy(out.m_model, m_modelMatrix.getData(), sizeof(out.m_model));
+    const float* n = m_normalMatrix.getData();
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            out.m_normal[column * 3 + row] = n[column * 4 + row];
+        }
+    }
+}
 
-    // Normal matrix = inverse-transpose of model
-    LibMath::Matrix4 normalMat = m_modelMatrix.inverse().transpose();
-    GLint locNorm = glGetUniformLocation(shader->getID(), "uNormalMatrix");
-    glUniformMatrix4fv(locNorm, 1, GL_FALSE, normalMat.getData());
+LibMath::Vector3 Mesh::getWorldCenter() const
+{
+    const float* m = m_modelMatrix.getData();
+    const LibMath::Point3D c = m_model->getBoundingSphere().getCenter();
+    return LibMath::Vector3(
+        m[0] * c.getX() + m[4] * c.getY() + m[8] * c.getZ() + m[12],
+        m[1] * c.getX() + m[5] * c.getY() + m[9] * c.getZ() + m[13],
+        m[2] * c.getX() + m[6] * c.getY() + m[10] * c.getZ() + m[14]);
+}
 
-    GLint opacity = glGetUniformLocation(shader->getID(), "u_opacity");
-    glUniform1f(opacity, m_texture->getOpacity());
+void Mesh::selectLod(const LibMath::Vector3& cameraPosition, float projectionScale)
+{
+    std::span<const Model::Lod> lods = m_model->getLods();
+    if (lods.size() < 2)
+    {
+        m_lod = 0;
+        return;
+    }
 
-    // 4) Draw the underlying model
-    m_model->draw();
+    // World bounding sphere: centre through the model matrix, radius by the largest axis scale
+    const float* m = m_modelMatrix.getData();
+    const LibMath::Vector3 center = getWorldCenter();
+    const float scale = std::max({
+        LibMath::Vector3(m[0], m[1], m[2]).magnitude(),
+        LibMath::Vector3(m[4], m[5], m[6]).magnitude(),
+        LibMath::Vector3(m[8], m[9], m[10]).magnitude() });
+
+    // Nearest point of the sphere; from inside it only full detail will do
+    const float distance = (center - cameraPosition).magnitude() - m_model->getBoundingSphere().getRadius() * scale;
+    if (distance <= 0.0f)
+    {
+        m_lod = 0;
+        return;
+    }
 
-    // 5) Unbind texture (optional)
-    glBindTexture(GL_TEXTURE_2D, 0);
+    auto pixelError = [&](size_t lod) { return lods[lod].m_error * scale * projectionScale / distance; };
+
+    size_t lod = std::min(m_lod, lods.size() - 1);
+    while (lod > 0 && pixelError(lod) > k_lodPixelError)
+        --lod;
+    while (lod + 1 < lods.size() && pixelError(lod + 1) < k_lodPixelError * k_lodHysteresis)
+        ++lod;
+    m_lod = lod;
 }
 
 bool Mesh::loadInstances(
     const std::string& transformFilePath,
     std::unordered_multimap<int, Mesh*>& outMeshes,
-    ResourceManager& manager)
+    ResourceManager& manager,
+    AssetLoader* loader)
 {
-    std::ifstream infile(transformFilePath);
-    if (!infile.is_open()) {
-        std::cerr << "Mesh::LoadInstances error: cannot open file: "
-            << transformFilePath << "\n";
+    LevelData level;
+    if (!level.parseLevelText(transformFilePath))
         return false;
-    }
-
-    // Temporary multimap to accumulate results
-    std::unordered_multimap<int, Mesh*> tempMap;
-    tempMap.reserve(128);
-
-    std::string line;
-    int        lineNumber = 0;
-
-    while (std::getline(infile, line)) {
-        ++lineNumber;
+    return loadInstances(level, outMeshes, manager, loader);
+}
 
-        // 1) Trim leading whitespace
-        size_t i = 0;
-        while (i < line.size() && std::isspace((unsigned char)line[i])) {
-            ++i;
-        }
-        // 2) Skip blank lines
-        if (i >= line.size()) {
-            continue;
+bool Mesh::loadInstances(
+    const LevelData& level,
+    std::unordered_multimap<int, Mesh*>& outMeshes,
+    ResourceManager& manager,
+    AssetLoader* loader)
+{
+    // 1) Resolve each model once (waiting for it if it is still loading)
+    std::vector<Model*> models;
+    std::vector<bool>   boundsValid;
+    models.reserve(level.getModels().size());
+    boundsValid.reserve(level.getModels().size());
+    for (uint32_t i = 0; i < level.getModels().size(); ++i) {
+        std::string_view name = level.getModelName(i);
+        NameId modelName = manager.findName(name);
+        Model* model = manager.get(manager.find<Model>(modelName));
+        if (model && loader && !loader->wait(manager.nameOf(modelName))) {
+            model = nullptr;
         }
-        // 3) Skip comments (lines starting with '#')
-        if (line[i] == '#') {
-            continue;
+        if (!model) {
+            std::cerr << "Mesh::LoadInstances error: no Model named \""
+                << name << "\" in ResourceManager\n";
+            return false;
         }
-
-        // 4) Parse: id objectType textureName px py pz rx ry rz
-        std::istringstream iss(line);
-        int         id;
-        std::string objectType, textureName;
-        float       px, py, pz, rx, ry, rz, sx, sy, sz;
-        float ppx, ppy, ppz;
-
-        if (!(iss >> id >> objectType >> textureName >> px >> py >> pz >> rx >> ry >> rz >> sx >> sy >> sz)) {
-            std::cerr << "Mesh::LoadInstances parse error at line "
-                << lineNumber << ": expected format:\n"
-                << "    <id> <objectType> <textureName> <px> <py> <pz> <rx> <ry> <rz>\n"
-                << "  got: \"" << line << "\"\n";
-            for (auto& kv : tempMap) {
-                delete kv.second;
+        models.push_back(model);
+
+        // Precomputed object bounds only hold while the model is the one the level was compiled against
+        const LevelData::ModelEntry& entry = level.getModels()[i];
+        bool valid = entry.m_hasBounds != 0;
+        if (valid) {
+            LibMath::Point3D min = model->getBounds().getMin(), max = model->getBounds().getMax();
+            valid = entry.m_boundsMin[0] == min.getX() && entry.m_boundsMin[1] == min.getY() && entry.m_boundsMin[2] == min.getZ()
+                 && entry.m_boundsMax[0] == max.getX() && entry.m_boundsMax[1] == max.getY() && entry.m_boundsMax[2] == max.getZ();
+            if (!valid) {
+                std::cerr << "Mesh::LoadInstances: model \"" << name
+                    << "\" changed since the level was compiled, recomputing its colliders\n";
             }
-            return false;
         }
+        boundsValid.push_back(valid);
+    }
 
-        if (id >= 8 && id <= 11 && (iss >> ppx >> ppy >> ppz)) { /*moving cube endpoint*/ }
-
-        // 5) Look up Model* by objectType
-        Model* model = manager.get<Model>(objectType);
-        if (!model) {
-            std::cerr << "Mesh::LoadInstances error at line "
-                << lineNumber << ": no Model named \""
-                << objectType << "\" in ResourceManager\n";
-            for (auto& kv : tempMap) {
-                delete kv.second;
-            }
+    // 2) Resolve each material once ("none" for no texture)
+    std::vector<MaterialInstance*> materials;
+    materials.reserve(level.getMaterials().size());
+    for (uint32_t i = 0; i < level.getMaterials().size(); ++i) {
+        MaterialInstance* material = manager.get(manager.find<MaterialInstance>(level.getMaterialName(i)));
+        if (!material) {
+            std::cerr << "Mesh::LoadInstances error: no MaterialInstance named \""
+                << level.getMaterialName(i) << "\" in ResourceManager\n";
             return false;
         }
+        materials.push_back(material);
+    }
 
-        // 6) Look up Texture* by textureName (or allow "none" for no texture)
-        Texture* texture = nullptr;
-        if (textureName != "none") {
-            texture = manager.get<Texture>(textureName);
-            if (!texture) {
-                std::cerr << "Mesh::LoadInstances error at line "
-                    << lineNumber << ": no Texture named \""
-                    << textureName << "\" in ResourceManager\n";
-                for (auto& kv : tempMap) {
-                    delete kv.second;
-                }
-                return false;
-            }
+    // 3) One Mesh per object, the world matrix and bounds come ready-made
+    std::unordered_multimap<int, Mesh*> tempMap;
+    tempMap.reserve(level.getObjects().size());
+    for (const LevelData::Object& object : level.getObjects()) {
+        Mesh* mesh = new Mesh(models[object.m_model]);
+        mesh->setMaterial(object.m_material == LevelData::k_none ? nullptr : materials[object.m_material]);
+        mesh->setModelMatrix(LevelData::toMatrix(object.m_world));
+        if (object.m_hasBounds && boundsValid[object.m_model]) {
+            mesh->setWorldBounds(LevelData::toBounds(object.m_boundsMin, object.m_boundsMax));
         }
-
-        // 7) Build the world‐space transform:
-        Matrix4 worldMat = Matrix4::identity();
-        worldMat = worldMat * Matrix4::createTranslation(Vector3(px, py, pz));
-        worldMat = worldMat * Matrix4::createRotationX(Degree(rx));
-        worldMat = worldMat * Matrix4::createRotationY(Degree(ry));
-        worldMat = worldMat * Matrix4::createRotationZ(Degree(rz));
-        worldMat = worldMat * Matrix4::createScale(LibMath::Vector3(sx, sy, sz));
-
-        // 8) Create the new Mesh instance and insert into tempMap
-        Mesh* mesh = new Mesh(model, texture);
-        mesh->setModelMatrix(worldMat);
-        tempMap.emplace(id, mesh);
+        tempMap.emplace(object.m_id, mesh);
     }
 
-    // 9) Success: commit into outMeshes
+    // 4) Success: commit into outMeshes
     outMeshes.swap(tempMap);
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,55 @@
+#include "MeshBatcher.h"
+#include <algorithm>
+
+MeshBatcher::~MeshBatcher()
+{
+    if (m_buffer)
+        glDeleteBuffers(1, &m_buffer);
+}
+
+bool MeshBatcher::sameGroup(const Mesh& a, const Mesh& b)
+{
+    return a.getModel() == b.getModel() && a.getLod() == b.getLod()
+        && a.getTexture() == b.getTexture() && a.getOpacity() == b.getOpacity();
+}
+
+void MeshBatcher::flush(const Shader& shader, const Mesh::Uniforms& uniforms, const LibMath::Matrix4& viewProj,
+                        Mesh::DrawState& state)
+{
+    if (m_meshes.empty())
+        return;
+
+    // Every instance of the flush in one buffer, in draw order
+    m_instances.resize(m_meshes.size());
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+        m_meshes[i]->writeInstance(m_instances[i]);
+
+    const size_t bytes = m_instances.size() * sizeof(InstanceData);
+    if (!m_buffer)
+        glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    if (bytes > m_capacity)
+        m_capacity = std::max(bytes, m_capacity * 2);
+    // Orphan the previous contents, the driver need not wait for the draws still reading them
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(m_capacity), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(bytes), m_instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader.set(uniforms.m_viewProj, viewProj);
+
+    for (size_t first = 0; first < m_meshes.size();)
+    {
+        size_t last = first + 1;
+        while (last < m_meshes.size() && sameGroup(*m_meshes[first], *m_meshes[last]))
+            ++last;
+
+        const Mesh& mesh = *m_meshes[first];
+        mesh.bindMaterial(shader, uniforms, state);
+        mesh.getModel()->drawInstanced(mesh.getLod(), m_buffer, first * sizeof(InstanceData), GLsizei(last - first));
+
+        ++m_drawCount;
+        m_instanceCount += last - first;
+        first = last;
+    }
+    m_meshes.clear();
+}
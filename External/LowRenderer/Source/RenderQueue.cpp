@@ -0,0 +1,82 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    uint64_t field(uint64_t value, int bits)
+    {
+        return value & ((uint64_t(1) << bits) - 1);
+    }
+
+    uint64_t quantizeDepth(float depth)
+    {
+        uint32_t bits;
+        const float clamped = std::max(depth, 0.0f);
+        std::memcpy(&bits, &clamped, sizeof(bits));
+        return bits >> (31 - RenderQueue::k_depthBits);
+    }
+}
+
+uint32_t RenderQueue::materialId(const Mesh& mesh)
+{
+    const uint32_t texture = m_objectIds.try_emplace(mesh.getTexture(), uint32_t(m_objectIds.size())).first->second;
+    uint32_t opacity;
+    const float value = mesh.getOpacity();
+    std::memcpy(&opacity, &value, sizeof(opacity));
+    return m_materialIds.try_emplace(uint64_t(texture) << 32 | opacity, uint32_t(m_materialIds.size())).first->second;
+}
+
+uint32_t RenderQueue::modelId(const Mesh& mesh)
+{
+    return m_objectIds.try_emplace(mesh.getModel(), uint32_t(m_objectIds.size())).first->second;
+}
+
+void RenderQueue::submit(const Mesh* mesh, Pass pass, uint32_t shader, float depth)
+{
+    const uint64_t state = field(shader, k_shaderBits) << (k_materialBits + k_modelBits + k_lodBits)
+                         | field(materialId(*mesh), k_materialBits) << (k_modelBits + k_lodBits)
+                         | field(modelId(*mesh), k_modelBits) << k_lodBits
+                         | field(mesh->getLod(), k_lodBits);
+    const uint64_t distance = quantizeDepth(depth);
+    const int stateBits = k_shaderBits + k_materialBits + k_modelBits + k_lodBits;
+
+    uint64_t key = uint64_t(pass) << 62;
+    if (pass == Pass::Opaque)
+        key |= state << k_depthBits | distance;
+    else
+        key |= field(~distance, k_depthBits) << stateBits | state;
+
+    m_items.push_back({ key, mesh, pass });
+}
+
+void RenderQueue::sort()
+{
+    // One pass over the keys counts all eight digits
+    size_t counts[8][256] = {};
+    for (const Item& item : m_items)
+    {
+        for (int digit = 0; digit < 8; ++digit)
+            ++counts[digit][(item.m_key >> (digit * 8)) & 0xFF];
+    }
+
+    m_scratch.resize(m_items.size());
+    for (int digit = 0; digit < 8; ++digit)
+    {
+        // Every key has the same byte here: the pass would not move anything
+        const size_t* count = counts[digit];
+        if (std::any_of(count, count + 256, [&](size_t n) { return n == m_items.size(); }))
+            continue;
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (int i = 0; i < 256; ++i)
+        {
+            offsets[i] = offset;
+            offset += count[i];
+        }
+        for (const Item& item : m_items)
+            m_scratch[offsets[(item.m_key >> (digit * 8)) & 0xFF]++] = item;
+        m_items.swap(m_scratch);
+    }
+}
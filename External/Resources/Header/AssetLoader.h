@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Model;
+class Texture;
+class TextureAtlas;
+
+/// Loads resources on a worker pool.
+/// Workers do the CPU side (OBJ parse or .smesh mapping, image decode) and queue the GL side, which the GL thread
+/// runs in drainUploads() within a per-frame byte budget. Every request gets a shared_future that becomes ready
+/// once the resource is fully usable (true) or failed (false).
+///
+/// The resource objects are created by the caller on the GL thread (ResourceManager is not thread-safe);
+/// the loader only fills them in.
+class AssetLoader
+{
+public:
+    using Completion = std::shared_future<bool>;
+
+    /// workerCount 0: one worker per hardware thread, minus the GL thread
+    explicit AssetLoader(unsigned workerCount = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    Completion  loadModel(const std::string& name, Model* model, const std::string& objPath);
+    Completion  loadTexture(const std::string& name, Texture* texture, const std::string& path);
+
+    /// Textures loaded from now on are packed into this atlas when it accepts them (nullptr: never).
+    /// The atlas is only touched by uploads, on the GL thread.
+    void        setTextureAtlas(TextureAtlas* atlas) { m_atlas = atlas; }
+
+    /// Completion of a named request (an invalid future if the name was never requested)
+    Completion  find(const std::string& name) const;
+
+    /// GL thread: block until the named request completes, running uploads meanwhile.
+    /// Returns true if it was never requested (nothing to wait for) or loaded successfully.
+    bool        wait(const std::string& name);
+    /// GL thread: same, for a completion returned by a load (true for an invalid one)
+    bool        wait(const Completion& completion);
+    /// GL thread: wait for every request
+    bool        waitAll();
+
+    /// GL thread: run queued uploads until byteBudget is spent (at least one runs if any is queued).
+    /// Returns the number of bytes uploaded.
+    size_t      drainUploads(size_t byteBudget);
+
+    /// Requests not completed yet
+    size_t      getPendingCount() const;
+    unsigned    getWorkerCount() const { return unsigned(m_workers.size()); }
+
+    /// Drop queued work and join the workers. Called by the destructor; call it before the GL context goes away.
+    void        shutdown();
+
+private:
+    struct Upload
+    {
+        size_t                              m_bytes = 0;
+        std::function<bool()>               m_run;
+        std::shared_ptr<std::promise<bool>> m_done;
+    };
+
+    Completion  submit(const std::string& name, std::function<void(std::shared_ptr<std::promise<bool>>)> job);
+    void        queueUpload(Upload upload);
+    void        workerLoop();
+
+    std::vector<std::thread>                        m_workers;
+    TextureAtlas*                                   m_atlas = nullptr;
+
+    mutable std::mutex                              m_jobMutex;
+    std::condition_variable                         m_jobReady;
+    std::deque<std::function<void()>>               m_jobs;
+    bool                                            m_stopping = false;
+
+    mutable std::mutex                              m_uploadMutex;
+    std::condition_variable                         m_uploadReady;
+    std::deque<Upload>                              m_uploads;
+
+    std::unordered_map<std::string, Completion>     m_completions;  // GL thread only
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LibMath/Vector.h"
+#include "LibMath/Geometry3D.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct Vertex;
+
+/// Position-only stand-in for a model's geometry, kept on the CPU when the full vertex and index
+/// arrays are released after the GPU upload (Model::Residency::GpuOnly). Colliders are fitted to it.
+///  - Bounds: the 8 corners of the local AABB (exact for box colliders)
+///  - ConvexHull: the hull of the vertices (box and capsule colliders fit it as they fit the full mesh,
+///    up to the hull tolerance of 1e-5 of the model size)
+///  - DecimatedMesh: the positions and triangles of the coarsest LOD
+class CollisionProxy {
+public:
+    enum class Kind { None, Bounds, ConvexHull, DecimatedMesh };
+
+    /// Build from the full geometry. A hull of flat or degenerate geometry falls back to Bounds.
+    void build(Kind kind, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+               const LibMath::Prism3DAABB& bounds);
+    void clear();
+
+    Kind                            getKind()      const { return m_kind; }
+    bool                            empty()        const { return m_positions.empty(); }
+    std::span<const LibMath::Vector3> getPositions() const { return m_positions; }
+    std::span<const uint32_t>       getIndices()   const { return m_indices; }   ///< Triangles (none for Bounds)
+    size_t                          getBytes()     const;
+
+private:
+    bool buildHull(std::span<const Vertex> vertices);
+    void buildBounds(const LibMath::Prism3DAABB& bounds);
+    void buildDecimated(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+
+    Kind                            m_kind = Kind::None;
+    std::vector<LibMath::Vector3>   m_positions;
+    std::vector<uint32_t>           m_indices;
+};
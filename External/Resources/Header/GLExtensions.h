@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Tokens of the entry points below, not in the 3.3 glad header
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#define GL_PROGRAM_BINARY_FORMATS           0x87FF
+#endif
+
+/// Entry points above the GL 3.3 core profile glad was generated for.
+/// load() resolves them once the context exists; each feature reports whether it can be used,
+/// callers keep a 3.3 fallback for when it cannot.
+namespace GLExtensions
+{
+    /// Resolve the optional entry points (GL thread, after gladLoadGLLoader)
+    void    load(GLADloadproc loader);
+
+    /// True if the context is at least major.minor or advertises the named extension
+    bool    hasExtension(const char* name);
+    bool    hasVersion(int major, int minor);
+
+    // --- Immutable texture storage (GL 4.2 / ARB_texture_storage) ---
+    bool    hasTextureStorage();
+    void    texStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+
+    // --- Program binaries (GL 4.1 / ARB_get_program_binary, with at least one binary format) ---
+    bool    hasProgramBinary();
+    void    programParameteri(GLuint program, GLenum name, GLint value);
+    void    getProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    void    programBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+}
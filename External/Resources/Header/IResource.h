@@ -1,11 +1,86 @@
 #pragma once
+#include<cstddef>
+#include<cstdint>
 
 
+/// Base of every resource owned by ResourceManager.
+/// Carries an intrusive reference count (taken by ResourceRef) and the residency hooks the manager
+/// uses to evict unreferenced resources under its memory budget. Evicting frees the data but keeps the
+/// object, so raw pointers stay valid; the data is restored when a reference is taken again.
+/// Reference counts and residency are GL thread only.
 class IResource
 {
 public:
 
 	virtual ~IResource() = default;
+
+	/// Bytes held in CPU memory, and the estimate of what the data uses on the GPU
+	virtual size_t	getCpuBytes() const { return 0; }
+	virtual size_t	getGpuBytes() const { return 0; }
+
+	/// Free the data (GL thread). Returns false if there is nothing to free (not loaded yet, or cannot be reloaded).
+	virtual bool	evict() { return false; }
+	/// Reload evicted data, from the caches when they exist (GL thread)
+	virtual bool	restore() { return true; }
+
+	bool			isEvicted() const { return m_evicted; }
+	uint32_t		getRefCount() const { return m_refCount; }
+	uint64_t		getLastUse() const { return m_lastUse; }
+
+	/// Take a reference, reloading the data first if it was evicted (GL thread)
+	void			addRef()
+	{
+		++m_refCount;
+		if (m_evicted && restore())
+			m_evicted = false;
+		touch();
+	}
+	void			release()
+	{
+		--m_refCount;
+		touch();
+	}
+
+	/// Mark as used now, for the least recently used order of evictions
+	void			touch()
+	{
+		m_lastUse = ++s_useClock;
+	}
+
+private:
+	friend class ResourceManager;
+
+	uint32_t		m_refCount = 0;
+	bool			m_evicted = false;
+	uint64_t		m_lastUse = 0;
+
+	inline static uint64_t s_useClock = 0;
 };
 
+/// Counted reference to a resource: the resource is never evicted while a ResourceRef points at it.
+/// Converts to and from T* so it can replace a raw pointer member.
+template<typename T>
+class ResourceRef
+{
+public:
+	ResourceRef() = default;
+	ResourceRef(T* resource) : m_resource(resource) { if (m_resource) m_resource->addRef(); }
+	ResourceRef(const ResourceRef& other) : ResourceRef(other.m_resource) {}
+	ResourceRef(ResourceRef&& other) noexcept : m_resource(other.m_resource) { other.m_resource = nullptr; }
+	~ResourceRef() { if (m_resource) m_resource->release(); }
+
+	ResourceRef& operator=(ResourceRef other) noexcept
+	{
+		T* previous = m_resource;
+		m_resource = other.m_resource;
+		other.m_resource = previous;
+		return *this;
+	}
+
+	T*		get() const { return m_resource; }
+	T*		operator->() const { return m_resource; }
+	operator T*() const { return m_resource; }
 
+private:
+	T*		m_resource = nullptr;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "VirtualFileSystem.h"
+#include "SourceStamp.h"
+#include "LibMath/Matrix/Matrix4.h"
+#include "LibMath/Geometry3D.h"
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// A level layout (placed objects and lights), either parsed from the text formats
+/// (LevelTest.txt, lights.txt) or memory mapped from a compiled .slvl built by the LevelCompiler tool.
+///
+/// Model and material names are interned once into tables; objects refer to them by index, so
+/// instantiating a level does no per-object string work. The records are plain data and are the
+/// exact bytes of the .slvl file: loading a compiled level is a mapping plus a few checks.
+class LevelData {
+public:
+    static constexpr uint32_t k_none = 0xFFFFFFFFu;    ///< No material ("none" in the text format)
+
+    /// One placed object ("<id> <model> <material> px py pz rx ry rz sx sy sz" in the text format)
+    struct Object {
+        int32_t  m_id;
+        uint32_t m_model;           ///< Index into getModels()
+        uint32_t m_material;        ///< Index into getMaterials(), or k_none
+        uint32_t m_hasBounds;       ///< World bounds below are valid (compiled levels only)
+        float    m_world[16];       ///< Model-to-world matrix, Matrix4::getData() order
+        float    m_boundsMin[3];    ///< World-space AABB of the transformed model vertices
+        float    m_boundsMax[3];
+    };
+
+    enum class LightType : uint32_t { Directional, Point, Spot };
+
+    /// One light ("<type> px py pz dx dy dz ambient diffuse specular [c l q] [inner outer]")
+    struct Light {
+        LightType m_type;
+        float     m_transform[16];  ///< Directional: rotation, point: translation, spot: translation * rotation
+        float     m_ambient[4];
+        float     m_diffuse[4];
+        float     m_specular[4];
+        float     m_constant;
+        float     m_linear;
+        float     m_quadratic;
+        float     m_cutOff;         ///< Radians
+        float     m_outerCutOff;    ///< Radians
+    };
+
+    /// A model name, with the local bounds the object bounds were computed from (compiled levels only)
+    struct ModelEntry {
+        uint32_t m_nameOffset;
+        uint32_t m_nameLength;
+        uint32_t m_hasBounds;
+        float    m_boundsMin[3];
+        float    m_boundsMax[3];
+    };
+
+    struct MaterialEntry {
+        uint32_t m_nameOffset;
+        uint32_t m_nameLength;
+    };
+
+    /// Parse the text formats. Each replaces the matching part of the level (objects or lights).
+    bool parseLevelText(const std::string& path);
+    bool parseLightsText(const std::string& path);
+
+    /// Map a compiled level. Fails (without logging) if it is missing, malformed, or older than
+    /// either text source, in which case the caller parses the text instead.
+    bool loadCompiled(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath);
+
+    /// Write the current content as a compiled level, stamped with the two text sources
+    bool writeCompiled(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath) const;
+
+    /// Parse both text sources, fit the bounds of every object to its model (the OBJ modelMeshes names for it)
+    /// and write the compiled level: the whole LevelCompiler / AssetCooker step. The OBJs read are appended
+    /// to outMeshes, they are inputs of the compiled level as much as the text sources.
+    bool compile(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath,
+                 const std::map<std::string, std::string, std::less<>>& modelMeshes, std::vector<std::string>* outMeshes = nullptr);
+
+    /// Compile-time data: model local bounds and object world bounds (parsed levels only)
+    void setModelBounds(uint32_t model, const LibMath::Prism3DAABB& localBounds);
+    void setObjectBounds(size_t object, const LibMath::Prism3DAABB& worldBounds);
+
+    /// Path of the .slvl matching a level text path (same folder, extension replaced)
+    static std::string compiledPathFor(const std::string& levelPath);
+
+    bool                            isCompiled()   const { return m_file.isOpen(); }
+    std::span<const ModelEntry>     getModels()    const { return m_modelView; }
+    std::span<const MaterialEntry>  getMaterials() const { return m_materialView; }
+    std::span<const Object>         getObjects()   const { return m_objectView; }
+    std::span<const Light>          getLights()    const { return m_lightView; }
+
+    std::string_view                getModelName(uint32_t model) const;
+    std::string_view                getMaterialName(uint32_t material) const;
+
+    static LibMath::Matrix4         toMatrix(const float (&data)[16]);
+    static LibMath::Prism3DAABB     toBounds(const float (&min)[3], const float (&max)[3]);
+
+private:
+    uint32_t internModel(std::string_view name);
+    uint32_t internMaterial(std::string_view name);
+    uint32_t storeName(std::string_view name);
+    void     detach();     ///< Copy a mapped level into the owned arrays before editing it
+    void     refreshViews();
+
+    // Owned storage (parsed levels), the views point here or into m_file
+    std::string                 m_names;
+    std::vector<ModelEntry>     m_models;
+    std::vector<MaterialEntry>  m_materials;
+    std::vector<Object>         m_objects;
+    std::vector<Light>          m_lights;
+
+    VirtualFile                     m_file;
+    std::string_view                m_nameView;
+    std::span<const ModelEntry>     m_modelView;
+    std::span<const MaterialEntry>  m_materialView;
+    std::span<const Object>         m_objectView;
+    std::span<const Light>          m_lightView;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/// Read-only memory mapping of a whole file.
+/// The bytes stay valid (and string_views into them too) until the MappedFile is closed or destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /// Map the file, returns false (and logs) if it cannot be opened. An empty file maps to an empty view.
+    bool open(const std::string& path);
+    void close();
+
+    bool                isOpen() const { return m_isOpen; }
+    const char*         data()   const { return m_data; }
+    size_t              size()   const { return m_size; }
+    std::string_view    view()   const { return { m_data, m_size }; }
+
+private:
+    const char* m_data   = nullptr;
+    size_t      m_size   = 0;
+    bool        m_isOpen = false;
+#ifdef _WIN32
+    void*       m_file    = nullptr;
+    void*       m_mapping = nullptr;
+#endif
+};
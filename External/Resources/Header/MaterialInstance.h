@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IResource.h"
+
+class Texture;
+
+/// One use of a texture: the texture plus the per-use parameters (opacity).
+/// Cheap to create, any number of instances can share the same Texture.
+class MaterialInstance : public IResource
+{
+public:
+	MaterialInstance() = default;
+
+	void		set(Texture* texture, float opacity = 1.0f)
+	{
+		m_texture = texture;
+		m_opacity = opacity;
+	}
+
+	Texture*	getTexture() const { return m_texture; }
+	float		getOpacity() const { return m_opacity; }
+	void		setOpacity(float opacity) { m_opacity = opacity; }
+
+private:
+	Texture*	m_texture = nullptr;
+	float		m_opacity = 1.0f;
+};
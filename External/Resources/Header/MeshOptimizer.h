@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Model.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// Cook-time reordering of an indexed triangle list, run on freshly parsed models before their
+/// .smesh cache is written (so cached loads get it for free):
+///  - triangle order for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+///  - clusters of that order sorted outside-in, to cut overdraw without losing the cache gains
+///  - vertex order matching first use, so fetches walk the vertex buffer forward
+/// The mesh is the same set of triangles and vertices afterwards, only their order changes
+/// (vertices no triangle uses are dropped). simplify() builds the reduced triangle sets of the model LODs.
+class MeshOptimizer {
+public:
+    static constexpr size_t k_cacheSize = 16;           ///< Post-transform cache entries assumed (FIFO)
+    static constexpr float  k_overdrawThreshold = 1.05f; ///< ACMR the overdraw sort may cost, as a factor
+
+    struct Report {
+        float   m_acmrBefore = 0.0f;    ///< Average cache miss ratio: transformed vertices per triangle
+        float   m_acmrAfter = 0.0f;
+        size_t  m_clusterCount = 0;     ///< Clusters the overdraw pass sorted (0 if it kept the Tipsify order)
+    };
+
+    /// Run all passes in place
+    static Report optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    /// Triangle order for the vertex cache. Appends the first triangle of every cluster to outClusters
+    /// (a cluster ends where Tipsify ran out of neighbours and the cold cache could start over).
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& outClusters);
+
+    /// Sort the clusters by how much they face away from the mesh centre. Kept only if the ACMR stays
+    /// within k_overdrawThreshold of the cache-optimized order; returns whether it was.
+    static bool   optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters);
+
+    /// Renumber the vertices in order of first use by the index buffer
+    static void   optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    /// Quadric error metric simplification (Garland & Heckbert) into outIndices, reusing the input vertices.
+    /// Vertices are welded by position first, so attribute seams do not block collapses; a collapsed corner
+    /// takes the vertex of its new position whose normal is closest. Edges are collapsed onto one of their
+    /// ends, cheapest first, until targetTriangleCount is reached or the next collapse would cost more
+    /// than maxError. Collapses that flip a triangle are skipped and open borders are kept in place.
+    /// Returns the error reached, in object-space units.
+    static float  simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                           size_t targetTriangleCount, float maxError, std::vector<uint32_t>& outIndices);
+
+    /// Simulated FIFO cache misses per triangle
+    static float  computeACMR(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize = k_cacheSize);
+};
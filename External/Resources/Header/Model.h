@@ -1,10 +1,15 @@
 #pragma once
 
 #include"LibMath//Vector.h"
+#include "LibMath/Geometry3D.h"
 #include <IResource.h>
+#include "VirtualFileSystem.h"
+#include "CollisionProxy.h"
 #include <vector>
+#include <span>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <glad/glad.h>
 
 struct Vertex {
@@ -13,53 +18,168 @@ struct Vertex {
     LibMath::Vector2    m_uv;
 };
 
+/// Per-instance data of Model::drawInstanced: the model matrix, then the 3x3 normal matrix (both column-major)
+struct InstanceData {
+    float               m_model[16];
+    float               m_normal[9];
+};
+
+/// Compressed GPU vertex (16 bytes instead of 32): position as unorm16 within the model bounds
+/// (the fourth component pads it to 8 bytes), normal octahedral-encoded in two snorm16, UV as two halves.
+struct PackedVertex {
+    uint16_t            m_position[4];
+    int16_t             m_normal[2];
+    uint16_t            m_uv[2];
+};
+
 class Model : public IResource {
 public:
     Model() = default;
     ~Model() override;
 
-    /// Load any polygonal OBJ (triangles, quads, n-gons) with automatic fan-triangulation
+    /// Layout of the GPU vertex buffers. Chosen once, before any model is loaded; shaders drawing
+    /// compressed models are built with COMPRESSED_VERTICES defined.
+    enum class VertexFormat { Float, Compressed };
+    static void         setVertexFormat(VertexFormat format) { s_vertexFormat = format; }
+    static VertexFormat getVertexFormat() { return s_vertexFormat; }
+
+    /// What stays on the CPU once a model is on the GPU. GpuOnly releases the vertex and index arrays
+    /// after the upload and keeps a collision proxy instead (built at load, see setCollisionProxy).
+    enum class Residency { KeepGeometry, GpuOnly };
+    static void         setResidency(Residency residency) { s_residency = residency; }
+    static Residency    getResidency() { return s_residency; }
+
+    /// Log what each load does to the geometry (vertex cache reordering, LODs, compression error, released
+    /// bytes). Off by default; AssetCooker turns it on with --verbose.
+    static void         setVerbose(bool verbose) { s_verbose = verbose; }
+
+    /// Proxy kind for GpuOnly residency, set before loading (convex hull by default)
+    void                setCollisionProxy(CollisionProxy::Kind kind) { m_proxyKind = kind; }
+    const CollisionProxy& getCollisionProxy() const { return m_collisionProxy; }
+
+    /// False once GpuOnly residency released the vertices, colliders then fit the collision proxy
+    bool                isGeometryResident() const { return !m_vertexView.empty(); }
+
+    /// Largest error the compressed layout introduced on this model (all 0 for float models)
+    struct CompressionReport {
+        float   m_positionError = 0.0f;         ///< Object-space distance
+        float   m_normalErrorDegrees = 0.0f;
+        float   m_uvError = 0.0f;
+        size_t  m_floatBytes = 0;               ///< Vertex buffer size in each layout
+        size_t  m_packedBytes = 0;
+    };
+    const CompressionReport& getCompressionReport() const { return m_compressionReport; }
+
+    /// Load any polygonal OBJ (triangles, quads, n-gons) with automatic fan-triangulation.
+    /// A binary .smesh cache is written next to the source on first load and memory mapped on later ones.
+    /// Needs no GL context (only uploadToGPU does): AssetCooker cooks the .smesh files through it.
     bool loadFromOBJ(const std::string& filename);
 
+    /// Parse OBJ text into de-duplicated vertices and triangle indices (CPU only, no GL calls)
+    static bool parseOBJ(std::string_view            text,
+                         std::vector<Vertex>&        outVertices,
+                         std::vector<uint32_t>&      outIndices);
+
     /// Sends vertex/index data once to the GPU
     void uploadToGPU();
 
-    /// Draws using the currently bound shader
-    void draw() const;
-
-    const std::vector<Vertex>&   getVertices() const { return m_vertices; }
-    const std::vector<uint32_t>& getIndices()  const { return m_indices;  }
+    /// Draws count instances of a level of detail (0 = full detail) with the currently bound shader, their InstanceData read from instanceBuffer at byteOffset.
+    /// Shaders get the model matrix at k_instanceAttribute (4 locations) and the normal matrix right after (3).
+    void drawInstanced(size_t lod, GLuint instanceBuffer, size_t byteOffset, GLsizei count) const;
+    static constexpr GLuint      k_instanceAttribute = 3;
+
+    /// Simplified versions of the model, built on first load and stored in the .smesh cache. Every LOD
+    /// indexes the same vertices; its error is the largest object-space deviation the simplification allowed.
+    struct Lod {
+        uint32_t m_indexOffset;
+        uint32_t m_indexCount;
+        float    m_error;
+    };
+    static constexpr size_t      k_maxLods = 4;
+    std::span<const Lod>         getLods() const { return { m_lods, m_lodCount }; }
+
+    /// Views over the vertex/index data, either parsed or mapped from the .smesh cache.
+    /// getIndices() is the full detail triangle list, getLodIndices() any level.
+    std::span<const Vertex>      getVertices() const { return m_vertexView; }
+    std::span<const uint32_t>    getIndices()  const { return getLodIndices(0); }
+    std::span<const uint32_t>    getLodIndices(size_t lod) const {
+        return lod < m_lodCount && !m_indexView.empty() ? m_indexView.subspan(m_lods[lod].m_indexOffset, m_lods[lod].m_indexCount) : m_indexView;
+    }
+
+    /// Local-space bounds, computed on load
+    const LibMath::Prism3DAABB&  getBounds()         const { return m_bounds; }
+    const LibMath::Sphere3D&     getBoundingSphere() const { return m_boundingSphere; }
+
+    /// Dequantization of compressed positions, position = unorm * scale + offset (the bounds extent and minimum)
+    const LibMath::Vector3&      getPositionScale()  const { return m_positionScale; }
+    const LibMath::Vector3&      getPositionOffset() const { return m_positionOffset; }
+
+    /// Models with at most this many vertices are drawn with 16-bit indices
+    static constexpr size_t      k_maxShortIndexVertices = 65536;
+    GLenum                       getIndexType() const { return m_indexType; }
+
+    /// Path of the .smesh cache matching an OBJ path (same folder, extension replaced)
+    static std::string           cachePathFor(const std::string& objPath);
+
+    /// Memory of an uploaded model (0 while it is still loading, the data may be written by a worker)
+    size_t getCpuBytes() const override {
+        return m_isUploaded ? m_vertexView.size_bytes() + m_indexView.size_bytes() + m_collisionProxy.getBytes() : 0;
+    }
+    size_t getGpuBytes() const override { return m_gpuBytes; }
+    /// Free the vertex data and the GPU buffers, keeping the bounds (reloaded by restore, from the .smesh cache)
+    bool evict() override;
+    bool restore() override;
 
 private:
+    /// Build m_packedVertices from the float vertices and fill the compression report
+    void packVertices();
+
+    /// Append the simplified LODs to m_indices (parsed models only)
+    void buildLods();
+
+    /// CPU-side preparation shared by the parse and cache paths: compressed vertices, collision proxy
+    void prepareForUpload();
+
+    /// GpuOnly residency: drop the CPU geometry once uploaded, the proxy stays
+    void releaseGeometry();
+
+    // --- .smesh cache ---
+    bool loadCache(const std::string& cachePath, const std::string& sourcePath);
+    bool writeCache(const std::string& cachePath, const std::string& sourcePath, std::string_view sourceText) const;
+    void computeBounds();
+
     // --- OBJ parsing helpers ---
-    void parseVertexPosition(const std::string&        line,
-                             std::vector<LibMath::Vector3>& outPositions);
-
-    void parseVertexUV(const std::string&     line,
-                       std::vector<LibMath::Vector2>& outUVs);
-
-    void parseVertexNormal(const std::string&        line,
-                           std::vector<LibMath::Vector3>& outNormals);
-
-    void parseFaceVertex(
-        const std::string&                         token,
-        const std::vector<LibMath::Vector3>&       tempPositions,
-        const std::vector<LibMath::Vector2>&       tempUVs,
-        const std::vector<LibMath::Vector3>&       tempNormals,
-        std::unordered_map<std::string,uint32_t>&  vertexMap,
-        std::vector<Vertex>&                       outVertices,
-        std::vector<uint32_t>&                     outIndices
-    );
 
-    /// Read all tokens on the face line, then fan-triangulate any n-gon
-    void parseFace(
-        const std::string&                         line,
-        const std::vector<LibMath::Vector3>&       tempPositions,
-        const std::vector<LibMath::Vector2>&       tempUVs,
-        const std::vector<LibMath::Vector3>&       tempNormals,
-        std::unordered_map<std::string,uint32_t>&  vertexMap,
-        std::vector<Vertex>&                       outVertices,
-        std::vector<uint32_t>&                     outIndices
+    /// Open-addressing (linear probing) map from a resolved (v, vt, vn) index triple to a vertex index
+    class VertexKeyMap {
+    public:
+        explicit VertexKeyMap(size_t expectedCount);
+
+        /// Index already assigned to the triple, or newIndex after inserting it (outInserted tells which)
+        uint32_t findOrInsert(uint32_t v, uint32_t vt, uint32_t vn, uint32_t newIndex, bool& outInserted);
+
+    private:
+        struct Slot {
+            uint32_t m_v, m_vt, m_vn;   // 1-based, 0 when the attribute is missing
+            uint32_t m_index;           // k_empty for a free slot
+        };
+        static constexpr uint32_t k_empty = 0xFFFFFFFFu;
+
+        void grow();
+
+        std::vector<Slot>   m_slots;
+        size_t              m_count = 0;
+    };
+
+    /// Resolve one "v/vt/vn" face token, reusing the vertex if the same indices were seen before
+    static bool parseFaceVertex(
+        std::string_view                                token,
+        const std::vector<LibMath::Vector3>&            tempPositions,
+        const std::vector<LibMath::Vector2>&            tempUVs,
+        const std::vector<LibMath::Vector3>&            tempNormals,
+        VertexKeyMap&                                   vertexMap,
+        std::vector<Vertex>&                            outVertices,
+        uint32_t&                                       outIndex
     );
 
     // --- GPU buffer wrappers ---
@@ -72,8 +192,8 @@ private:
         void setData(GLsizeiptr size, const void* data, GLenum usage);
 
     private:
-        GLuint  m_id   = 0;
-        GLenum  m_type;
+        mutable GLuint  m_id = 0;   // Created on first bind
+        GLenum          m_type;
     };
 
     class VertexAttributes {
@@ -84,16 +204,39 @@ private:
         void unbind() const;
 
     private:
-        GLuint m_id = 0;
+        mutable GLuint  m_id = 0;   // Created on first bind
     };
 
     // --- Stored data ---
-    std::vector<Vertex>      m_vertices;
+    std::vector<Vertex>      m_vertices;        // Owned data when parsed from the OBJ
     std::vector<uint32_t>    m_indices;
+    VirtualFile              m_cacheFile;       // Mapped data when loaded from the .smesh cache
+    std::span<const Vertex>  m_vertexView;
+    std::span<const uint32_t> m_indexView;
+
+    LibMath::Prism3DAABB     m_bounds;
+    LibMath::Sphere3D        m_boundingSphere;
+    Lod                      m_lods[k_maxLods] = {};
+    size_t                   m_lodCount = 0;
+
+    std::vector<PackedVertex> m_packedVertices; // Compressed copy, freed once uploaded
+    LibMath::Vector3         m_positionScale{ 1.0f };
+    LibMath::Vector3         m_positionOffset;
+    CompressionReport        m_compressionReport;
+
+    static inline VertexFormat s_vertexFormat = VertexFormat::Float;
+    static inline Residency    s_residency = Residency::KeepGeometry;
+    static inline bool         s_verbose = false;
+
+    CollisionProxy::Kind     m_proxyKind = CollisionProxy::Kind::ConvexHull;
+    CollisionProxy           m_collisionProxy;
 
     VertexAttributes         m_vao;
     Buffer                   m_vbo{ GL_ARRAY_BUFFER };
     Buffer                   m_ebo{ GL_ELEMENT_ARRAY_BUFFER };
 
+    std::string              m_sourcePath;
+    size_t                   m_gpuBytes = 0;
+    GLenum                   m_indexType = GL_UNSIGNED_INT;
     bool                     m_isUploaded = false;
 };
\ No newline at end of file
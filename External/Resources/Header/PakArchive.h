@@ -0,0 +1,78 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Read-only .pak archive: the files of an asset tree in one file, mapped once.
+/// Layout: header, index of Entry sorted by name hash, name table, then the entry data. Each entry starts
+/// on a k_alignment boundary, so a stored entry can be used in place exactly like its own mapped file.
+/// Compressed entries (a byte-oriented LZ77 in the LZ4 block layout) are inflated on access.
+class PakArchive {
+public:
+    static constexpr uint32_t k_magic     = 0x4B415053;     ///< "SPAK"
+    static constexpr uint32_t k_version   = 1;
+    static constexpr size_t   k_alignment = 64;             ///< Entry data alignment (cache line, and enough for any header struct)
+    static constexpr size_t   k_minSaving = 8;              ///< Compression is kept only if it saves 1/k_minSaving of the entry
+
+    enum Flags : uint32_t { Compressed = 1 };
+
+    struct Entry {
+        uint64_t m_hash;            ///< hashName() of the name
+        uint64_t m_offset;          ///< From the start of the archive
+        uint64_t m_storedSize;      ///< Bytes in the archive
+        uint64_t m_size;            ///< Bytes once inflated
+        uint32_t m_nameOffset;      ///< Into the name table
+        uint32_t m_nameLength;
+        uint32_t m_flags;
+        uint32_t m_padding;
+    };
+
+    /// A file to pack
+    struct Source {
+        std::string         m_name;             ///< Relative to the archive root, '/' separated
+        std::string_view    m_bytes;            ///< Must stay valid until write() returns
+        bool                m_compress = true;  ///< False for data meant to be used in place (cooked caches)
+    };
+
+    struct WriteStats {
+        size_t   m_entryCount = 0;
+        size_t   m_compressedCount = 0;
+        uint64_t m_sourceBytes = 0;
+        uint64_t m_archiveBytes = 0;
+    };
+
+    PakArchive() = default;
+    PakArchive(PakArchive&&) noexcept = default;
+    PakArchive& operator=(PakArchive&&) noexcept = default;
+
+    /// Map and validate an archive, returns false (and logs) if it is unreadable or corrupt
+    bool open(const std::string& path);
+    void close();
+
+    bool                        isOpen()     const { return m_file.isOpen(); }
+    std::span<const Entry>      getEntries() const { return m_entries; }
+
+    /// Entry of a relative name (exact match, '/' separated), nullptr if there is none
+    const Entry*                find(std::string_view name) const;
+    std::string_view            getName(const Entry& entry) const;
+    /// The bytes as stored: the file itself unless the entry is Compressed
+    std::string_view            getStored(const Entry& entry) const;
+    /// Inflate a compressed entry into out (m_size bytes), false if its data is corrupt
+    bool                        inflate(const Entry& entry, char* out) const;
+
+    /// Pack sources into a new archive (written to a temporary file, then renamed over path)
+    static bool                 write(const std::string& path, std::span<const Source> sources, WriteStats* outStats = nullptr);
+
+    static uint64_t             hashName(std::string_view name);
+    static void                 compress(std::string_view bytes, std::vector<char>& out);
+    static bool                 decompress(std::string_view compressed, char* out, size_t size);
+
+private:
+    MappedFile                  m_file;
+    std::span<const Entry>      m_entries;
+    std::string_view            m_names;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include<cstdint>
+
+/// Index of an interned resource name (see ResourceManager::intern)
+using NameId = uint32_t;
+constexpr NameId k_invalidName = 0xFFFFFFFFu;
+
+/// Typed reference to a resource slot in ResourceManager.
+/// A slot's generation is bumped when its resource is deleted or replaced, so a stale handle
+/// resolves to nullptr instead of to whatever reuses the slot.
+template<typename T>
+struct Handle
+{
+	static constexpr uint32_t k_invalidIndex = 0xFFFFFFFFu;
+
+	uint32_t	m_index = k_invalidIndex;
+	uint32_t	m_generation = 0;
+
+	bool		isNull() const { return m_index == k_invalidIndex; }
+	bool		operator==(const Handle& other) const { return m_index == other.m_index && m_generation == other.m_generation; }
+	bool		operator!=(const Handle& other) const { return !(*this == other); }
+};
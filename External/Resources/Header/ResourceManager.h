@@ -1,56 +1,322 @@
 #pragma once
 #include<unordered_map>
 #include<string>
+#include<string_view>
+#include<vector>
+#include<memory>
+#include<cstdint>
+#include<type_traits>
 #include"IResource.h"
+#include"ResourceHandle.h"
 
+class Texture;
+
+/// Owns every resource, stored per type.
+/// Names are interned once into NameIds; each type keeps a slot array (the resource pointer, its generation
+/// and name) plus a NameId -> slot table, so a Handle<T> or a NameId resolves with two array reads and no RTTI.
+/// String lookups stay available for loading code; hot paths should keep the Handle.
+///
+/// Resources are reference counted through ResourceRef. With a memory budget set, update() evicts unreferenced
+/// resources least recently used first; an evicted resource reloads itself (from its cache) the next time a
+/// ResourceRef takes it. Lookups never reload anything.
 class ResourceManager
 {
+public:
+	/// Memory held by resources, per type or in total
+	struct MemoryStats
+	{
+		uint32_t	m_count = 0;
+		uint32_t	m_referenced = 0;
+		uint32_t	m_evicted = 0;
+		size_t		m_cpuBytes = 0;
+		size_t		m_gpuBytes = 0;
+
+		size_t		totalBytes() const { return m_cpuBytes + m_gpuBytes; }
+	};
 
 private:
-	std::unordered_map<std::string, IResource*> resources;
+	struct PoolBase
+	{
+		virtual ~PoolBase() = default;
+		// Unregister the name, returning its resource (nullptr if none). The resource stays in its slot until collected.
+		virtual IResource* detach(NameId name) = 0;
+		// Delete unnamed resources nobody references any more, bumping their slots' generation
+		virtual void collect() = 0;
+		virtual void addStats(MemoryStats& stats) const = 0;
+		virtual void gatherEvictable(std::vector<IResource*>& out) const = 0;
+	};
+
+	template<typename T>
+	struct Pool : PoolBase
+	{
+		struct Slot
+		{
+			T*			m_resource = nullptr;
+			uint32_t	m_generation = 1;
+			NameId		m_name = k_invalidName;
+		};
+
+		std::vector<Slot>		m_slots;
+		std::vector<uint32_t>	m_freeSlots;
+		std::vector<uint32_t>	m_slotByName;	// Per NameId: slot index, or Handle<T>::k_invalidIndex
+
+		~Pool() override
+		{
+			for (Slot& slot : m_slots)
+				delete slot.m_resource;
+		}
+
+		uint32_t slotOf(NameId name) const
+		{
+			return name < m_slotByName.size() ? m_slotByName[name] : Handle<T>::k_invalidIndex;
+		}
+
+		IResource* detach(NameId name) override
+		{
+			uint32_t index = slotOf(name);
+			if (index == Handle<T>::k_invalidIndex)
+				return nullptr;
+
+			m_slots[index].m_name = k_invalidName;
+			m_slotByName[name] = Handle<T>::k_invalidIndex;
+			return m_slots[index].m_resource;
+		}
+
+		void collect() override
+		{
+			for (uint32_t i = 0; i < m_slots.size(); ++i)
+			{
+				Slot& slot = m_slots[i];
+				if (!slot.m_resource || slot.m_name != k_invalidName || slot.m_resource->getRefCount() > 0)
+					continue;
+
+				delete slot.m_resource;
+				slot.m_resource = nullptr;
+				++slot.m_generation;
+				m_freeSlots.push_back(i);
+			}
+		}
+
+		void addStats(MemoryStats& stats) const override;
+
+		void gatherEvictable(std::vector<IResource*>& out) const override
+		{
+			for (const Slot& slot : m_slots)
+			{
+				if (slot.m_resource && slot.m_resource->getRefCount() == 0 && !slot.m_resource->isEvicted())
+					out.push_back(slot.m_resource);
+			}
+		}
+	};
+
+	// Transparent hashing, so string_view lookups do not build a std::string
+	struct NameHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+	};
+
+	std::unordered_map<std::string, NameId, NameHash, std::equal_to<>>	nameIds;
+	std::vector<std::string>											names;
+	std::vector<std::unique_ptr<PoolBase>>								pools;	// Indexed by typeIndex<T>()
+
+	// Textures by file content (size, hash of the bytes), so copies of an image share one texture
+	struct ContentKey
+	{
+		uint64_t m_size = 0;
+		uint64_t m_hash = 0;
+		bool operator==(const ContentKey& other) const { return m_size == other.m_size && m_hash == other.m_hash; }
+	};
+	struct ContentKeyHash
+	{
+		size_t operator()(const ContentKey& key) const { return size_t(key.m_hash ^ (key.m_size * 0x9E3779B97F4A7C15ull)); }
+	};
+	std::unordered_map<ContentKey, Texture*, ContentKeyHash> textureContents;
+
+	size_t  memoryBudget = 0;
+	size_t  evictionCount = 0;
+
+	// Drop what the manager knows about a resource that is being unregistered
+	void    forget(IResource* resource);
+
+	// Dense per-type index, assigned on first use of a type
+	inline static uint32_t s_typeCount = 0;
+	template<typename T>
+	static uint32_t typeIndex()
+	{
+		static const uint32_t index = s_typeCount++;
+		return index;
+	}
+
+	template<typename T>
+	Pool<T>*        pool() const
+	{
+		uint32_t index = typeIndex<T>();
+		return index < pools.size() ? static_cast<Pool<T>*>(pools[index].get()) : nullptr;
+	}
+
+	template<typename T>
+	Pool<T>&        poolFor()
+	{
+		uint32_t index = typeIndex<T>();
+		if (index >= pools.size())
+			pools.resize(index + 1);
+		if (!pools[index])
+			pools[index] = std::make_unique<Pool<T>>();
+		return *static_cast<Pool<T>*>(pools[index].get());
+	}
 
 public:
 
 	~ResourceManager();
 
+	/// Id of a name, registering it on first use. Ids stay valid for the manager's lifetime.
+	NameId  intern(std::string_view name);
+	/// Id of an already interned name, k_invalidName otherwise
+	NameId  findName(std::string_view name) const;
+	const std::string& nameOf(NameId id) const { return names[id]; }
+
+	/// Create a resource under a name. A previous resource of the same type and name is deleted, or kept
+	/// unnamed until its last ResourceRef goes away if it is still referenced (its handles stay valid meanwhile).
 	template<typename T>
 	T*      create(const std::string& name);
+	template<typename T>
+	Handle<T> createHandle(const std::string& name);
+
+	/// Resolve a name once, keep the handle
+	template<typename T>
+	Handle<T> find(std::string_view name) const;
+	template<typename T>
+	Handle<T> find(NameId name) const;
 
+	/// O(1); nullptr for a null or stale handle. Counts as a use for eviction, but an evicted resource stays
+	/// evicted: hold it through a ResourceRef (GL thread) to have its data back.
 	template<typename T>
-	T*      get(const std::string& name);
+	T*      get(Handle<T> handle) const;
+	template<typename T>
+	T*      get(const std::string& name) { return get(find<T>(std::string_view(name))); }
 
+	/// Delete the resources registered under a name, whatever their type (referenced ones live on unnamed)
 	void    delete_resource(const std::string& name);
+
+	/// CPU + GPU bytes above which unreferenced resources are evicted, least recently used first (0: no limit)
+	void    setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+	size_t  getMemoryBudget() const { return memoryBudget; }
+	/// Once per frame (GL thread): delete released unnamed resources, then evict down to the budget
+	void    update();
+
+	template<typename T>
+	MemoryStats getMemoryStats() const;
+	MemoryStats getMemoryStats() const;
+	size_t  getEvictionCount() const { return evictionCount; }
+
+	/// Texture for an image file, stored under its normalized path.
+	/// Files are matched by path first, then by content, so one GPU texture serves every name and
+	/// every copy of an image. outIsNew is set when the texture was just created and still has to be loaded.
+	Texture* acquireTexture(const std::string& path, bool& outIsNew);
 };
 
 
 template<typename T>
-T* ResourceManager::create(const std::string& name) 
+Handle<T> ResourceManager::createHandle(const std::string& name) 
 {
 	// Ensure T is derived from IResource
     static_assert(std::is_base_of<IResource, T>::value, "T must inherit from IResource");
 
-	// Check if the resource already exists
-    auto it = resources.find(name);
-    if (it != resources.end()) {
-        delete it -> second;
-        resources.erase(it);
+	// Replace the resource if it already exists
+    NameId id = intern(name);
+    Pool<T>& storage = poolFor<T>();
+    if (IResource* previous = storage.detach(id)) {
+        forget(previous);
+        storage.collect();
     }
 
-	// create a new resource of type T
-    T* resource = new T();
-    resources[name] = resource;
-    return resource;
+	// create a new resource of type T, reusing a free slot if any
+    uint32_t index;
+    if (!storage.m_freeSlots.empty()) {
+        index = storage.m_freeSlots.back();
+        storage.m_freeSlots.pop_back();
+    }
+    else {
+        index = uint32_t(storage.m_slots.size());
+        storage.m_slots.emplace_back();
+    }
+
+    auto& slot = storage.m_slots[index];
+    slot.m_resource = new T();
+    slot.m_name = id;
+    if (id >= storage.m_slotByName.size())
+        storage.m_slotByName.resize(names.size(), Handle<T>::k_invalidIndex);
+    storage.m_slotByName[id] = index;
+    return Handle<T>{ index, slot.m_generation };
+}
+
+template<typename T>
+T* ResourceManager::create(const std::string& name) 
+{
+    return get(createHandle<T>(name));
 }
 
 template<typename T>
-T* ResourceManager::get(const std::string& name) 
+Handle<T> ResourceManager::find(NameId name) const
 {
     static_assert(std::is_base_of<IResource, T>::value, "T must inherit from IResource");
 
-    auto it = resources.find(name);
-    if (it != resources.end()) {
-        return dynamic_cast<T*>(it -> second);
+    const Pool<T>* storage = pool<T>();
+    if (!storage)
+        return {};
+
+    uint32_t index = storage->slotOf(name);
+    if (index == Handle<T>::k_invalidIndex)
+        return {};
+    return Handle<T>{ index, storage->m_slots[index].m_generation };
+}
+
+template<typename T>
+Handle<T> ResourceManager::find(std::string_view name) const
+{
+    NameId id = findName(name);
+    return id == k_invalidName ? Handle<T>{} : find<T>(id);
+}
+
+template<typename T>
+T* ResourceManager::get(Handle<T> handle) const
+{
+    const Pool<T>* storage = pool<T>();
+    if (!storage || handle.m_index >= storage->m_slots.size())
+        return nullptr;
+
+    const auto& slot = storage->m_slots[handle.m_index];
+    if (slot.m_generation != handle.m_generation || !slot.m_resource)
+        return nullptr;
+
+    slot.m_resource->touch();
+    return slot.m_resource;
+}
+
+template<typename T>
+void ResourceManager::Pool<T>::addStats(MemoryStats& stats) const
+{
+    for (const Slot& slot : m_slots)
+    {
+        if (!slot.m_resource)
+            continue;
+
+        ++stats.m_count;
+        if (slot.m_resource->getRefCount() > 0)
+            ++stats.m_referenced;
+        if (slot.m_resource->isEvicted())
+            ++stats.m_evicted;
+        stats.m_cpuBytes += slot.m_resource->getCpuBytes();
+        stats.m_gpuBytes += slot.m_resource->getGpuBytes();
     }
+}
 
-    return nullptr;
-}
\ No newline at end of file
+template<typename T>
+ResourceManager::MemoryStats ResourceManager::getMemoryStats() const
+{
+    MemoryStats stats;
+    if (const Pool<T>* storage = pool<T>())
+        storage->addStats(stats);
+    return stats;
+}
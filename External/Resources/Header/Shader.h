@@ -1,27 +1,93 @@
 #pragma once
 
 #include "IResource.h"
+#include "LibMath/Vector/Vector3.h"
+#include "LibMath/Vector/Vector4.h"
+#include "LibMath/Matrix/Matrix4.h"
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
 #include <filesystem>
 #include <glad/glad.h>
 
+/// Location of an active uniform, resolved once through Shader::uniform.
+/// An invalid handle (uniform missing or optimized out) makes the setters no-ops.
+struct UniformHandle
+{
+    GLint   m_location = -1;
+
+    bool    isValid() const { return m_location >= 0; }
+};
+
 class Shader : public IResource {
 public:
     Shader();
     ~Shader();
 
+    /// Read a stage's source; compiling waits for link(), which may not need it
     bool    setVertexShader(const std::string& filename);
     bool    setFragmentShader(const std::string& filename);
+    /// Add "#define name value" after the #version line of every stage (before link())
+    void    addDefine(const std::string& name, const std::string& value = "");
+    /// Load the program from the binary cache, or compile and link the sources and refresh the cache
     bool    link();
 
     void    use() const;
     GLuint  getID() const;
 	void    setInt(const std::string& name, int value) const;
 
+    /// Active uniform by name, from the table built at link (hash lookup, no GL call).
+    /// Resolve handles once after link, per-frame code should only use the setters below.
+    UniformHandle                       uniform(std::string_view name) const;
+    /// Every element of an array uniform or array-of-struct member, by array index:
+    /// uniformArray("pointLights[].position")[3] is "pointLights[3].position", uniformArray("weights[]")[1] is "weights[1]".
+    /// Indices the program does not use hold invalid handles.
+    const std::vector<UniformHandle>&   uniformArray(std::string_view pattern) const;
+
+    // Typed setters, on the program in use
+    void    set(UniformHandle handle, int value) const;
+    void    set(UniformHandle handle, float value) const;
+    void    set(UniformHandle handle, const LibMath::Vector3& value) const;
+    void    set(UniformHandle handle, const LibMath::Vector4& value) const;
+    void    set(UniformHandle handle, const LibMath::Matrix4& value) const;
+
+    /// True if the last link() was served by the binary cache
+    bool    isFromCache() const { return m_fromCache; }
+
+    /// Folder of the program binary cache, one <key>.sprog per program (empty: no cache).
+    /// The key hashes the sources, the defines and the driver strings, so any change falls back to a compile.
+    static void setCacheDirectory(const std::filesystem::path& directory) { s_cacheDirectory = directory; }
+
 private:
-    GLuint              m_programID;
-    std::vector<GLuint> m_attachedShaders;
+    struct Stage {
+        GLenum      m_type;
+        std::string m_source;
+    };
+
+    GLuint                                              m_programID;
+    std::vector<Stage>                                  m_stages;
+    std::vector<std::pair<std::string, std::string>>    m_defines;
+    bool                                                m_fromCache = false;
+
+    // Transparent hashing, so string_view lookups do not build a std::string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    std::unordered_map<std::string, UniformHandle, NameHash, std::equal_to<>>               m_uniforms;
+    std::unordered_map<std::string, std::vector<UniformHandle>, NameHash, std::equal_to<>>  m_uniformArrays;
+
+    inline static std::filesystem::path                 s_cacheDirectory;
 
     bool            compileShader(const std::string& source, GLenum shaderType, GLuint& shaderID);
     std::string     loadFile(const std::string& filepath);
-};
\ No newline at end of file
+    std::string     withDefines(const std::string& source) const;
+    uint64_t        cacheKey() const;
+    bool            loadBinary(const std::filesystem::path& path, uint64_t key);
+    void            saveBinary(const std::filesystem::path& path, uint64_t key) const;
+    void            reflectUniforms();
+    void            addUniform(const std::string& name, GLint location);
+};
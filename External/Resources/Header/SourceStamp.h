@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Identity of a source file, stored in the caches built from it (.smesh, .stex).
+/// Size and write time are checked first; the content hash settles it when only the time changed
+/// (copied or checked-out files).
+struct SourceStamp
+{
+    uint64_t    m_size = 0;
+    int64_t     m_time = 0;     // last_write_time, in file clock ticks
+    uint64_t    m_hash = 0;     // FNV-1a of the content
+
+    /// Stamp a source file whose content is already in memory
+    static bool     make(const std::string& path, std::string_view content, SourceStamp& outStamp);
+    static uint64_t hash(std::string_view bytes);
+
+    /// True if the file at path still matches, or if it is missing (a cache can ship without its source).
+    /// outRetimed is set when only the write time differed and the content hash settled it.
+    bool            matches(const std::string& path, bool* outRetimed = nullptr) const;
+
+    /// After a match settled by the hash: take the source's current time and store the stamp at offset in
+    /// the cache file, so the next load matches on size and time alone. The cache must not be mapped.
+    bool            rewrite(const std::string& sourcePath, const std::string& cachePath, size_t offset);
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+/// Line-based tokenizer over a block of text (typically a MappedFile view).
+/// Tokens are string_views into the source text, numbers are parsed in place with std::from_chars:
+/// nothing is copied or allocated. Blank lines and lines starting with '#' are skipped.
+///
+///     TextTokenizer tok(file.view());
+///     while (tok.nextLine()) {
+///         std::string_view tag = tok.next();
+///         float x;
+///         if (!tok.next(x)) { /* error at tok.lineNumber() */ }
+///     }
+class TextTokenizer {
+public:
+    explicit TextTokenizer(std::string_view text) : m_text(text) {
+        // Skip a UTF-8 byte order mark
+        if (m_text.size() >= 3 && m_text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            m_text.remove_prefix(3);
+    }
+
+    /// Move to the next line holding a token. Returns false at the end of the text.
+    bool nextLine() {
+        while (m_pos < m_text.size()) {
+            size_t end = m_text.find('\n', m_pos);
+            if (end == std::string_view::npos)
+                end = m_text.size();
+
+            m_line   = m_text.substr(m_pos, end - m_pos);
+            m_cursor = 0;
+            m_pos    = end + 1;
+            ++m_lineNumber;
+
+            skipSpaces();
+            if (m_cursor < m_line.size() && m_line[m_cursor] != '#')
+                return true;
+        }
+        m_line   = {};
+        m_cursor = 0;
+        return false;
+    }
+
+    /// Next whitespace-separated token of the current line, empty at the end of the line.
+    std::string_view next() {
+        skipSpaces();
+        size_t start = m_cursor;
+        while (m_cursor < m_line.size() && !isSpace(m_line[m_cursor]))
+            ++m_cursor;
+        return m_line.substr(start, m_cursor - start);
+    }
+
+    /// Parse the next token as a number. On failure the value is left untouched.
+    template<typename T>
+    bool next(T& outValue) {
+        return parse(next(), outValue);
+    }
+
+    /// True when the current line has no token left.
+    bool atLineEnd() {
+        skipSpaces();
+        return m_cursor >= m_line.size();
+    }
+
+    std::string_view    line()       const { return m_line; }
+    int                 lineNumber() const { return m_lineNumber; }
+
+    /// Parse a whole token as a number (a leading '+' is accepted). Returns false on any leftover character.
+    template<typename T>
+    static bool parse(std::string_view token, T& outValue) {
+        if (!token.empty() && token.front() == '+')
+            token.remove_prefix(1);
+        if (token.empty())
+            return false;
+
+        T value{};
+        auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc() || end != token.data() + token.size())
+            return false;
+
+        outValue = value;
+        return true;
+    }
+
+private:
+    // Spaces, tabs, CR and other control characters all separate tokens
+    static bool isSpace(char c) { return static_cast<unsigned char>(c) <= ' '; }
+
+    void skipSpaces() {
+        while (m_cursor < m_line.size() && isSpace(m_line[m_cursor]))
+            ++m_cursor;
+    }
+
+    std::string_view    m_text;
+    std::string_view    m_line;
+    size_t              m_pos        = 0;
+    size_t              m_cursor     = 0;
+    int                 m_lineNumber = 0;
+};
@@ -1,9 +1,40 @@
 #pragma once
 
 #include <IResource.h>
+#include "TextureAtlas.h"
 #include <filesystem>
+#include <memory>
+#include <vector>
 #include <glad/glad.h>
 
+/// Decoded pixels and their full mip chain, produced by Texture::decode (safe on any thread)
+/// and consumed by Texture::upload (GL thread)
+struct TextureData
+{
+	struct Level
+	{
+		int							m_width = 0;
+		int							m_height = 0;
+		const unsigned char*		m_pixels = nullptr;
+		size_t						m_size = 0;
+	};
+
+	std::filesystem::path			m_path;
+	int								m_width = 0;
+	int								m_height = 0;
+	int								m_channels = 0;
+	std::vector<Level>				m_levels;		// Level 0 first, down to 1x1
+	std::shared_ptr<const void>		m_storage;		// Owns the level pixels (mapped .stex or decoded buffer)
+
+	size_t							byteSize() const
+	{
+		size_t size = 0;
+		for (const Level& level : m_levels)
+			size += level.m_size;
+		return size;
+	}
+};
+
 class Texture : public IResource
 {
 public:
@@ -11,18 +42,33 @@ public:
 	~Texture();
 
 	GLuint							getID() const { return m_textureID; }
+	/// Decode and upload in one go (GL thread)
 	bool							loadTexture(std::filesystem::path const& filename);
+	/// Load an image and its mip chain as bottom-up rows, without touching GL.
+	/// Maps the .stex cache next to the image when it is up to date, otherwise decodes the image,
+	/// filters the mips on the CPU and rewrites the cache. Returns false if the image cannot be read.
+	/// A single-colour image is stored as a k_solidSize square of that colour, whatever its size.
+	static bool						decode(std::filesystem::path const& filename, TextureData& outData);
+	/// Path of the mip chain cache for an image (same name, .stex extension)
+	static std::filesystem::path	cachePathFor(std::filesystem::path const& filename);
+	/// Create the GL texture from decoded pixels (GL thread).
+	/// With an atlas, a texture it accepts becomes a tile of it instead of a GL texture of its own.
+	bool							upload(const TextureData& data, TextureAtlas* atlas = nullptr);
 	const std::filesystem::path&	getPath() const { return m_path; }
-	void setOpacity(float opacity)
-	{
-		m_opacity = opacity;
-	}
-	float getOpacity()
-	{
-		return m_opacity;
-	}
+
+	/// Packed in a TextureAtlas: getID() is 0, the region locates the tile
+	bool							isAtlased() const { return m_region.m_layer >= 0; }
+	const AtlasRegion&				getAtlasRegion() const { return m_region; }
+
+	static constexpr int			k_solidSize = TextureAtlas::k_cellSize;	///< Side of a single-colour image once decoded
+
+	size_t							getGpuBytes() const override { return m_gpuBytes; }
+	/// Delete the GL texture (reloaded from the .stex cache by restore). Atlas tiles stay resident.
+	bool							evict() override;
+	bool							restore() override;
 private:
 	GLuint							m_textureID;
 	std::filesystem::path			m_path;
-	float m_opacity = 1;
-};
\ No newline at end of file
+	size_t							m_gpuBytes = 0;
+	AtlasRegion						m_region;
+};
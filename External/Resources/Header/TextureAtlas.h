@@ -0,0 +1,92 @@
+#pragma once
+
+#include "LibMath/Geometry2D.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+struct TextureData;
+
+/// Where a texture lives inside a TextureAtlas: the array layer, and the transform from the
+/// texture's own [0,1] UVs to the tile (atlas UV = offset + fract(uv) * scale)
+struct AtlasRegion
+{
+	float		m_scale[2] = { 1.0f, 1.0f };
+	float		m_offset[2] = { 0.0f, 0.0f };
+	int			m_layer = -1;		// -1: not in an atlas
+};
+
+/// MaxRects packer: the free space of a page is a list of maximal free rectangles, each placement
+/// goes to the one that leaves the shortest leftover side and splits every free rectangle it overlaps.
+class AtlasPacker
+{
+public:
+	AtlasPacker(int width, int height);
+
+	/// Find room for a width x height rectangle, false if the page is too full
+	bool							insert(int width, int height, LibMath::RectangleAABB& outRect);
+	/// Fraction of the page area in use
+	float							getOccupancy() const;
+
+private:
+	void							split(const LibMath::RectangleAABB& used);
+	void							prune();
+
+	int								m_width;
+	int								m_height;
+	uint64_t						m_usedArea = 0;
+	std::vector<LibMath::RectangleAABB>	m_free;
+};
+
+/// Small textures packed into the layers of one GL_TEXTURE_2D_ARRAY, so meshes using any of them
+/// draw without rebinding a texture. Each page is a layer packed with AtlasPacker.
+///
+/// A tile keeps its own mip chain (copied from the texture's levels, never filtered across tiles) and a
+/// k_padding border that wraps the texture around, so the shader can repeat UVs with fract() and bilinear
+/// taps at the edges read the opposite side, as GL_REPEAT would. Tiles sit on a 2^(k_levelCount-1) texel
+/// grid, so the border is still one texel at the coarsest level the atlas keeps.
+class TextureAtlas
+{
+public:
+	static constexpr int	k_pageSize = 1024;
+	static constexpr int	k_levelCount = 4;
+	static constexpr int	k_cellSize = 1 << (k_levelCount - 1);	///< Placement grid, in level 0 texels
+	static constexpr int	k_padding = k_cellSize;					///< Wrapped border around each tile
+	static constexpr int	k_maxEntrySize = 256;					///< Larger textures keep their own GL texture
+	static constexpr int	k_maxPages = 16;
+
+	TextureAtlas() = default;
+	~TextureAtlas();
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	/// True if the texture is small enough for a tile and has the levels the atlas samples
+	static bool				accepts(const TextureData& data);
+
+	/// Pack a texture and upload its tile (GL thread). False if it is not accepted or every page is full;
+	/// the caller then gives the texture its own GL texture.
+	bool					add(const TextureData& data, AtlasRegion& outRegion);
+
+	/// Bind the array on a texture unit (unit 0 is left active)
+	void					bind(GLuint unit) const;
+	GLuint					getID() const { return m_textureID; }
+	int						getPageCount() const { return int(m_pages.size()); }
+	size_t					getEntryCount() const { return m_entryCount; }
+	size_t					getGpuBytes() const;
+
+private:
+	struct Page
+	{
+		AtlasPacker						m_packer{ k_pageSize / k_cellSize, k_pageSize / k_cellSize };
+		std::vector<unsigned char>		m_levels[k_levelCount];		// RGBA, bottom-up rows, kept to re-upload when the array grows
+	};
+
+	void					allocate();
+	void					uploadTile(int layer, int x, int y, int width, int height) const;
+
+	std::vector<Page>		m_pages;
+	GLuint					m_textureID = 0;
+	int						m_allocatedPages = 0;
+	size_t					m_entryCount = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "PakArchive.h"
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Bytes of one asset, wherever they came from: a stored entry of the mounted archive (used in place),
+/// the inflated copy of a compressed entry, or a loose file mapped on its own.
+/// Same interface as MappedFile, and the same lifetime rule: views stay valid until it is closed or destroyed.
+class VirtualFile {
+public:
+    VirtualFile() = default;
+    VirtualFile(const VirtualFile&) = delete;
+    VirtualFile& operator=(const VirtualFile&) = delete;
+    VirtualFile(VirtualFile&& other) noexcept;
+    VirtualFile& operator=(VirtualFile&& other) noexcept;
+
+    void                close();
+
+    bool                isOpen()   const { return m_isOpen; }
+    bool                isPacked() const { return m_isPacked; }     ///< Read from the archive, not from disk
+    const char*         data()     const { return m_view.data(); }
+    size_t              size()     const { return m_view.size(); }
+    std::string_view    view()     const { return m_view; }
+
+private:
+    friend class VirtualFileSystem;
+
+    MappedFile          m_file;         // Loose file
+    std::vector<char>   m_buffer;       // Inflated entry
+    std::string_view    m_view;
+    bool                m_isOpen = false;
+    bool                m_isPacked = false;
+};
+
+/// Asset lookup through one mounted .pak, falling back to the disk.
+/// Paths are the ones the game already uses ("../../Assets/Meshes/Door.obj"): a path under the mount root
+/// is looked up in the archive by its relative name, anything the archive does not hold (or any path when
+/// nothing is mounted) is read from disk, so loose files still work during development.
+/// A loose file written after the archive wins over its entry (logged), so an edit shows up before the next cook.
+/// Mount before any loading starts: lookups from loader threads are lock free and never see a remount.
+class VirtualFileSystem {
+public:
+    /// Map the archive and serve the paths under root from it. False if it is missing (silently)
+    /// or invalid (logged); lookups then go to disk.
+    static bool                 mount(const std::string& archivePath, const std::string& root);
+    /// Stored entries are used in place: unmount only once nothing mapped from the archive is in use
+    static void                 unmount();
+    static bool                 isMounted() { return s_archive.isOpen(); }
+
+    static bool                 exists(const std::string& path);
+    /// The whole file, in place for stored entries. False (and logs) if it is nowhere to be found.
+    static bool                 map(const std::string& path, VirtualFile& outFile);
+    /// Stream over map()'s bytes, nullptr if the file is missing
+    static std::unique_ptr<std::istream> open(const std::string& path);
+
+    /// Name of a path inside the archive, empty if the path is not under the mount root
+    static std::string          archiveName(const std::string& path);
+    static const PakArchive&    getArchive() { return s_archive; }
+
+private:
+    static const PakArchive::Entry* findEntry(const std::string& path);
+    /// A loose file at path is newer than the mounted archive
+    static bool                 isOverridden(const std::string& path);
+
+    inline static PakArchive    s_archive;
+    inline static std::filesystem::file_time_type s_archiveTime;
+    inline static std::string   s_root;     // Lexically normal, generic separators, ends with '/'
+};
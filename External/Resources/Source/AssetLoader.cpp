@@ -0,0 +1,194 @@
+#include "AssetLoader.h"
+#include "Model.h"
+#include "Texture.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+AssetLoader::AssetLoader(unsigned workerCount)
+{
+    if (workerCount == 0)
+    {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_workers.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+    shutdown();
+}
+
+void AssetLoader::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        if (m_stopping && m_workers.empty())
+            return;
+        m_stopping = true;
+        m_jobs.clear();
+    }
+    m_jobReady.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+
+    // Pending uploads point at resources that may be gone, fail them instead
+    std::lock_guard<std::mutex> lock(m_uploadMutex);
+    for (Upload& upload : m_uploads)
+        upload.m_done->set_value(false);
+    m_uploads.clear();
+}
+
+void AssetLoader::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobReady.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping)
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+AssetLoader::Completion AssetLoader::submit(const std::string& name, std::function<void(std::shared_ptr<std::promise<bool>>)> job)
+{
+    auto done = std::make_shared<std::promise<bool>>();
+    Completion completion = done->get_future().share();
+    m_completions[name] = completion;
+
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.emplace_back([job = std::move(job), done]() { job(done); });
+    }
+    m_jobReady.notify_one();
+    return completion;
+}
+
+void AssetLoader::queueUpload(Upload upload)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_uploadMutex);
+        m_uploads.push_back(std::move(upload));
+    }
+    m_uploadReady.notify_all();
+}
+
+AssetLoader::Completion AssetLoader::loadModel(const std::string& name, Model* model, const std::string& objPath)
+{
+    return submit(name, [this, model, objPath](std::shared_ptr<std::promise<bool>> done)
+    {
+        // Parse (or map the .smesh cache) here, only the buffer upload needs the GL thread
+        if (!model->loadFromOBJ(objPath))
+        {
+            std::cerr << "Model load failed: " << objPath << "\n";
+            done->set_value(false);
+            return;
+        }
+
+        Upload upload;
+        upload.m_bytes = model->getVertices().size_bytes() + model->getIndices().size_bytes();
+        upload.m_run = [model]() { model->uploadToGPU(); return true; };
+        upload.m_done = std::move(done);
+        queueUpload(std::move(upload));
+    });
+}
+
+AssetLoader::Completion AssetLoader::loadTexture(const std::string& name, Texture* texture, const std::string& path)
+{
+    return submit(name, [this, texture, path, atlas = m_atlas](std::shared_ptr<std::promise<bool>> done)
+    {
+        auto data = std::make_shared<TextureData>();
+        if (!Texture::decode(path, *data))
+        {
+            std::cerr << "Texture load failed: " << path << "\n";
+            done->set_value(false);
+            return;
+        }
+
+        Upload upload;
+        upload.m_bytes = data->byteSize();
+        upload.m_run = [texture, data, atlas]() { return texture->upload(*data, atlas); };
+        upload.m_done = std::move(done);
+        queueUpload(std::move(upload));
+    });
+}
+
+AssetLoader::Completion AssetLoader::find(const std::string& name) const
+{
+    auto it = m_completions.find(name);
+    return it != m_completions.end() ? it->second : Completion();
+}
+
+size_t AssetLoader::drainUploads(size_t byteBudget)
+{
+    size_t spent = 0;
+    for (;;)
+    {
+        Upload upload;
+        {
+            std::lock_guard<std::mutex> lock(m_uploadMutex);
+            if (m_uploads.empty() || (spent > 0 && spent + m_uploads.front().m_bytes > byteBudget))
+                break;
+            upload = std::move(m_uploads.front());
+            m_uploads.pop_front();
+        }
+
+        bool ok = upload.m_run();
+        spent += upload.m_bytes;
+        upload.m_done->set_value(ok);
+    }
+    return spent;
+}
+
+bool AssetLoader::wait(const std::string& name)
+{
+    return wait(find(name));
+}
+
+bool AssetLoader::wait(const Completion& completion)
+{
+    if (!completion.valid())
+        return true;
+
+    // The completion may depend on an upload only this thread can run
+    while (completion.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        if (drainUploads(SIZE_MAX) == 0)
+        {
+            std::unique_lock<std::mutex> lock(m_uploadMutex);
+            m_uploadReady.wait_for(lock, std::chrono::milliseconds(1), [this]() { return !m_uploads.empty(); });
+        }
+    }
+    return completion.get();
+}
+
+bool AssetLoader::waitAll()
+{
+    bool ok = true;
+    for (const auto& [name, completion] : m_completions)
+        ok = wait(name) && ok;
+    return ok;
+}
+
+size_t AssetLoader::getPendingCount() const
+{
+    size_t pending = 0;
+    for (const auto& [name, completion] : m_completions)
+    {
+        if (completion.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            ++pending;
+    }
+    return pending;
+}
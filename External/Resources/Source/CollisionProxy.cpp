@@ -0,0 +1,258 @@
+#include "CollisionProxy.h"
+#include "Model.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t k_unused = 0xFFFFFFFFu;
+
+    struct HullFace {
+        uint32_t                m_v[3];
+        LibMath::Vector3        m_normal;   // Unit, pointing out of the hull
+        float                   m_offset;   // normal . p for p on the face
+        bool                    m_alive;
+        std::vector<uint32_t>   m_outside;  // Points in front of this face, not yet on the hull
+    };
+
+    uint64_t edgeKey(uint32_t from, uint32_t to) { return (uint64_t(from) << 32) | to; }
+}
+
+void CollisionProxy::build(Kind kind, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                           const LibMath::Prism3DAABB& bounds) {
+    clear();
+    switch (kind) {
+    case Kind::Bounds:
+        buildBounds(bounds);
+        break;
+    case Kind::ConvexHull:
+        if (!buildHull(vertices))
+            buildBounds(bounds);
+        break;
+    case Kind::DecimatedMesh:
+        buildDecimated(vertices, indices);
+        break;
+    case Kind::None:
+        break;
+    }
+}
+
+void CollisionProxy::clear() {
+    m_kind = Kind::None;
+    std::vector<LibMath::Vector3>().swap(m_positions);
+    std::vector<uint32_t>().swap(m_indices);
+}
+
+size_t CollisionProxy::getBytes() const {
+    return m_positions.size() * sizeof(LibMath::Vector3) + m_indices.size() * sizeof(uint32_t);
+}
+
+void CollisionProxy::buildBounds(const LibMath::Prism3DAABB& bounds) {
+    const LibMath::Point3D min = bounds.getMin(), max = bounds.getMax();
+    m_kind = Kind::Bounds;
+    m_positions.reserve(8);
+    for (int corner = 0; corner < 8; ++corner) {
+        m_positions.emplace_back(
+            corner & 1 ? max.getX() : min.getX(),
+            corner & 2 ? max.getY() : min.getY(),
+            corner & 4 ? max.getZ() : min.getZ());
+    }
+}
+
+// Quickhull: start from a tetrahedron of extreme points, each face keeping the points in front of it.
+// The farthest point of a face joins the hull: the faces it sees are removed and the hole is closed
+// with a fan from the point to the horizon edges, then the orphaned points go to the new faces.
+bool CollisionProxy::buildHull(std::span<const Vertex> vertices) {
+    if (vertices.size() < 4)
+        return false;
+
+    std::vector<LibMath::Vector3> points;
+    points.reserve(vertices.size());
+    for (const Vertex& v : vertices)
+        points.push_back(v.m_position);
+
+    LibMath::Vector3 extentMin = points[0], extentMax = points[0];
+    for (const LibMath::Vector3& p : points) {
+        extentMin.m_x = std::min(extentMin.m_x, p.m_x); extentMax.m_x = std::max(extentMax.m_x, p.m_x);
+        extentMin.m_y = std::min(extentMin.m_y, p.m_y); extentMax.m_y = std::max(extentMax.m_y, p.m_y);
+        extentMin.m_z = std::min(extentMin.m_z, p.m_z); extentMax.m_z = std::max(extentMax.m_z, p.m_z);
+    }
+    const float epsilon = (extentMax - extentMin).magnitude() * 1e-5f;
+    if (epsilon <= 0.0f)
+        return false;
+
+    // 1) Initial tetrahedron: two far apart points, the farthest from their line, the farthest from their plane
+    uint32_t a = 0, b = 0;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        if (points[i].m_x < points[a].m_x) a = i;
+        if (points[i].m_x > points[b].m_x) b = i;
+    }
+    if ((points[b] - points[a]).magnitude() <= epsilon) {
+        for (uint32_t i = 0; i < points.size(); ++i)
+            if ((points[i] - points[a]).magnitudeSquared() > (points[b] - points[a]).magnitudeSquared()) b = i;
+    }
+    const LibMath::Vector3 ab = points[b] - points[a];
+    uint32_t c = a;
+    float best = 0.0f;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        float distance = ab.cross(points[i] - points[a]).magnitude();
+        if (distance > best) { best = distance; c = i; }
+    }
+    if (best <= epsilon * ab.magnitude())
+        return false;
+
+    LibMath::Vector3 planeNormal = ab.cross(points[c] - points[a]);
+    planeNormal.normalize();
+    uint32_t d = a;
+    best = 0.0f;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        float distance = std::fabs(planeNormal.dot(points[i] - points[a]));
+        if (distance > best) { best = distance; d = i; }
+    }
+    if (best <= epsilon)
+        return false;   // Flat geometry (floors, walls), no volume to wrap
+
+    std::vector<HullFace> faces;
+    std::unordered_map<uint64_t, uint32_t> faceOfEdge;     // Directed edge -> face holding it
+    auto addFace = [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+        HullFace face{ { i0, i1, i2 }, (points[i1] - points[i0]).cross(points[i2] - points[i0]), 0.0f, true, {} };
+        face.m_normal.normalize();
+        face.m_offset = face.m_normal.dot(points[i0]);
+        const uint32_t f = uint32_t(faces.size());
+        for (int e = 0; e < 3; ++e)
+            faceOfEdge[edgeKey(face.m_v[e], face.m_v[(e + 1) % 3])] = f;
+        faces.push_back(std::move(face));
+        return f;
+    };
+    auto distanceTo = [&](uint32_t f, uint32_t point) { return faces[f].m_normal.dot(points[point]) - faces[f].m_offset; };
+
+    // Wind the tetrahedron outwards
+    if (planeNormal.dot(points[d] - points[a]) > 0.0f)
+        std::swap(b, c);
+    std::vector<uint32_t> pending = { addFace(a, b, c), addFace(a, d, b), addFace(b, d, c), addFace(c, d, a) };
+
+    // Give every point to the first face it is in front of, points behind all faces are inside for good
+    auto assign = [&](uint32_t point, const uint32_t* candidates, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            if (distanceTo(candidates[k], point) > epsilon) {
+                faces[candidates[k]].m_outside.push_back(point);
+                return;
+            }
+        }
+    };
+    for (uint32_t i = 0; i < points.size(); ++i)
+        assign(i, pending.data(), pending.size());
+
+    // 2) Add the farthest outside point of a face until none is left
+    std::vector<uint32_t> visible, stack, created, orphans;
+    std::vector<uint32_t> visitedBy;
+    std::vector<std::pair<uint32_t, uint32_t>> horizon;
+    while (!pending.empty()) {
+        const uint32_t seed = pending.back();
+        pending.pop_back();
+        if (!faces[seed].m_alive || faces[seed].m_outside.empty())
+            continue;
+
+        uint32_t eye = faces[seed].m_outside[0];
+        float farthest = distanceTo(seed, eye);
+        for (uint32_t point : faces[seed].m_outside) {
+            float distance = distanceTo(seed, point);
+            if (distance > farthest) {
+                farthest = distance;
+                eye = point;
+            }
+        }
+
+        // Faces the eye sees, as one patch grown across shared edges
+        visitedBy.resize(faces.size(), k_unused);
+        visible.clear();
+        horizon.clear();
+        stack.assign(1, seed);
+        visitedBy[seed] = eye;
+        while (!stack.empty()) {
+            uint32_t f = stack.back();
+            stack.pop_back();
+            visible.push_back(f);
+            const uint32_t* v = faces[f].m_v;
+            for (int e = 0; e < 3; ++e) {
+                auto neighbour = faceOfEdge.find(edgeKey(v[(e + 1) % 3], v[e]));
+                if (neighbour == faceOfEdge.end() || visitedBy[neighbour->second] == eye)
+                    continue;
+                if (distanceTo(neighbour->second, eye) > 0.0f) {
+                    visitedBy[neighbour->second] = eye;
+                    stack.push_back(neighbour->second);
+                }
+            }
+        }
+        for (uint32_t f : visible) {
+            const uint32_t* v = faces[f].m_v;
+            for (int e = 0; e < 3; ++e) {
+                auto neighbour = faceOfEdge.find(edgeKey(v[(e + 1) % 3], v[e]));
+                if (neighbour == faceOfEdge.end() || visitedBy[neighbour->second] != eye)
+                    horizon.emplace_back(v[e], v[(e + 1) % 3]);
+            }
+        }
+
+        orphans.clear();
+        for (uint32_t f : visible) {
+            const uint32_t* v = faces[f].m_v;
+            for (int e = 0; e < 3; ++e)
+                faceOfEdge.erase(edgeKey(v[e], v[(e + 1) % 3]));
+            faces[f].m_alive = false;
+            for (uint32_t point : faces[f].m_outside)
+                if (point != eye)
+                    orphans.push_back(point);
+            std::vector<uint32_t>().swap(faces[f].m_outside);
+        }
+
+        // The horizon keeps the winding of the removed faces, so the new faces face outwards too
+        created.clear();
+        for (const auto& [from, to] : horizon)
+            created.push_back(addFace(from, to, eye));
+        for (uint32_t point : orphans)
+            assign(point, created.data(), created.size());
+        for (uint32_t f : created)
+            if (!faces[f].m_outside.empty())
+                pending.push_back(f);
+    }
+
+    // 3) Keep only the points the hull uses
+    std::vector<uint32_t> remap(points.size(), k_unused);
+    for (const HullFace& face : faces) {
+        if (!face.m_alive)
+            continue;
+        for (uint32_t v : face.m_v) {
+            if (remap[v] == k_unused) {
+                remap[v] = uint32_t(m_positions.size());
+                m_positions.push_back(points[v]);
+            }
+            m_indices.push_back(remap[v]);
+        }
+    }
+    m_kind = Kind::ConvexHull;
+    return true;
+}
+
+void CollisionProxy::buildDecimated(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+    // Welded by position: the split normals and UVs mean nothing to a collider
+    struct PositionHash {
+        size_t operator()(const LibMath::Vector3& p) const {
+            return std::hash<float>()(p.m_x) ^ (std::hash<float>()(p.m_y) << 1) ^ (std::hash<float>()(p.m_z) << 2);
+        }
+    };
+    struct PositionEqual {
+        bool operator()(const LibMath::Vector3& l, const LibMath::Vector3& r) const {
+            return l.m_x == r.m_x && l.m_y == r.m_y && l.m_z == r.m_z;
+        }
+    };
+    std::unordered_map<LibMath::Vector3, uint32_t, PositionHash, PositionEqual> welded;
+
+    m_kind = Kind::DecimatedMesh;
+    m_indices.reserve(indices.size());
+    for (uint32_t index : indices) {
+        auto [it, inserted] = welded.try_emplace(vertices[index].m_position, uint32_t(m_positions.size()));
+        if (inserted)
+            m_positions.push_back(vertices[index].m_position);
+        m_indices.push_back(it->second);
+    }
+}
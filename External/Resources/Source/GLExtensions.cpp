@@ -0,0 +1,88 @@
+#include "GLExtensions.h"
+#include <cstring>
+
+namespace
+{
+    typedef void (APIENTRYP PFN_TexStorage2D)(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+
+    typedef void (APIENTRYP PFN_ProgramParameteri)(GLuint program, GLenum name, GLint value);
+    typedef void (APIENTRYP PFN_GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP PFN_ProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+
+    PFN_TexStorage2D        s_texStorage2D = nullptr;
+    PFN_ProgramParameteri   s_programParameteri = nullptr;
+    PFN_GetProgramBinary    s_getProgramBinary = nullptr;
+    PFN_ProgramBinary       s_programBinary = nullptr;
+}
+
+namespace GLExtensions
+{
+    void load(GLADloadproc loader)
+    {
+        s_texStorage2D = nullptr;
+        if (hasVersion(4, 2) || hasExtension("GL_ARB_texture_storage"))
+            s_texStorage2D = reinterpret_cast<PFN_TexStorage2D>(loader("glTexStorage2D"));
+
+        // Some drivers expose the extension with no format to save in (binaries disabled)
+        s_programParameteri = nullptr;
+        s_getProgramBinary = nullptr;
+        s_programBinary = nullptr;
+        GLint formatCount = 0;
+        if (hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary"))
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        if (formatCount > 0)
+        {
+            s_programParameteri = reinterpret_cast<PFN_ProgramParameteri>(loader("glProgramParameteri"));
+            s_getProgramBinary = reinterpret_cast<PFN_GetProgramBinary>(loader("glGetProgramBinary"));
+            s_programBinary = reinterpret_cast<PFN_ProgramBinary>(loader("glProgramBinary"));
+        }
+    }
+
+    bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool hasVersion(int major, int minor)
+    {
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+
+    bool hasTextureStorage()
+    {
+        return s_texStorage2D != nullptr;
+    }
+
+    void texStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height)
+    {
+        s_texStorage2D(target, levels, internalFormat, width, height);
+    }
+
+    bool hasProgramBinary()
+    {
+        return s_programParameteri && s_getProgramBinary && s_programBinary;
+    }
+
+    void programParameteri(GLuint program, GLenum name, GLint value)
+    {
+        s_programParameteri(program, name, value);
+    }
+
+    void getProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+    {
+        s_getProgramBinary(program, bufSize, length, binaryFormat, binary);
+    }
+
+    void programBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+    {
+        s_programBinary(program, binaryFormat, binary, length);
+    }
+}
@@ -0,0 +1,489 @@
+#include "LevelData.h"
+#include "Model.h"
+#include "TextTokenizer.h"
+#include "LibMath/Angle/Degree.h"
+#include "LibMath/Angle/Radian.h"
+#include "LibMath/Vector/Vector3.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// --- .slvl layout ---
+namespace {
+    constexpr uint32_t k_slvlMagic   = 0x4C564C53; // "SLVL"
+    constexpr uint32_t k_slvlVersion = 1;
+
+    // File layout: header, models, materials, objects, lights, then the name bytes.
+    // Every record is made of 4-byte fields, so each array stays aligned in the mapping.
+    struct SLevelHeader {
+        uint32_t    m_magic;
+        uint32_t    m_version;
+        uint32_t    m_objectSize;       // sizeof(LevelData::Object) when written, rejects layout changes
+        uint32_t    m_lightSize;
+        SourceStamp m_levelSource;      // LevelTest.txt the level was compiled from
+        SourceStamp m_lightsSource;     // lights.txt
+        uint32_t    m_modelCount;
+        uint32_t    m_materialCount;
+        uint32_t    m_objectCount;
+        uint32_t    m_lightCount;
+        uint32_t    m_nameBytes;
+        uint32_t    m_padding;
+    };
+    static_assert(sizeof(SLevelHeader) % 8 == 0, "SLevelHeader must keep the records aligned");
+
+    void storeMatrix(const LibMath::Matrix4& matrix, float (&out)[16]) {
+        std::memcpy(out, matrix.getData(), sizeof(out));
+    }
+
+    void storeBounds(const LibMath::Prism3DAABB& bounds, float (&outMin)[3], float (&outMax)[3]) {
+        LibMath::Point3D min = bounds.getMin(), max = bounds.getMax();
+        outMin[0] = min.getX(); outMin[1] = min.getY(); outMin[2] = min.getZ();
+        outMax[0] = max.getX(); outMax[1] = max.getY(); outMax[2] = max.getZ();
+    }
+
+    bool stampSource(const std::string& path, SourceStamp& outStamp) {
+        MappedFile file;
+        return file.open(path) && SourceStamp::make(path, file.view(), outStamp);
+    }
+
+    // Min/max of a set of points
+    struct BoundsBuilder {
+        LibMath::Vector3    m_min, m_max;
+        bool                m_empty = true;
+
+        void add(const LibMath::Vector3& p) {
+            if (m_empty) {
+                m_min = m_max = p;
+                m_empty = false;
+                return;
+            }
+            m_min.m_x = std::min(m_min.m_x, p.m_x); m_max.m_x = std::max(m_max.m_x, p.m_x);
+            m_min.m_y = std::min(m_min.m_y, p.m_y); m_max.m_y = std::max(m_max.m_y, p.m_y);
+            m_min.m_z = std::min(m_min.m_z, p.m_z); m_max.m_z = std::max(m_max.m_z, p.m_z);
+        }
+
+        LibMath::Prism3DAABB bounds() const {
+            return LibMath::Prism3DAABB(LibMath::Point3D(m_min.m_x, m_min.m_y, m_min.m_z), LibMath::Point3D(m_max.m_x, m_max.m_y, m_max.m_z));
+        }
+    };
+
+    // Local bounds, as Model computes them on load
+    LibMath::Prism3DAABB localBounds(const std::vector<Vertex>& vertices) {
+        BoundsBuilder builder;
+        for (const Vertex& vertex : vertices)
+            builder.add(vertex.m_position);
+        return builder.bounds();
+    }
+
+    // Same arithmetic as the collider built from a Mesh at runtime, so both agree to the bit
+    LibMath::Prism3DAABB worldBounds(const std::vector<Vertex>& vertices, const LibMath::Matrix4& world) {
+        const float* m = world.getData();
+        BoundsBuilder builder;
+        for (const Vertex& vertex : vertices) {
+            float x = vertex.m_position.m_x, y = vertex.m_position.m_y, z = vertex.m_position.m_z;
+            builder.add(LibMath::Vector3(
+                m[0] * x + m[4] * y + m[8] * z + m[12],
+                m[1] * x + m[5] * y + m[9] * z + m[13],
+                m[2] * x + m[6] * y + m[10] * z + m[14]));
+        }
+        return builder.bounds();
+    }
+}
+
+LibMath::Matrix4 LevelData::toMatrix(const float (&d)[16]) {
+    return LibMath::Matrix4(
+        d[0],  d[1],  d[2],  d[3],
+        d[4],  d[5],  d[6],  d[7],
+        d[8],  d[9],  d[10], d[11],
+        d[12], d[13], d[14], d[15]);
+}
+
+LibMath::Prism3DAABB LevelData::toBounds(const float (&min)[3], const float (&max)[3]) {
+    return LibMath::Prism3DAABB(LibMath::Point3D(min[0], min[1], min[2]), LibMath::Point3D(max[0], max[1], max[2]));
+}
+
+std::string LevelData::compiledPathFor(const std::string& levelPath) {
+    return std::filesystem::path(levelPath).replace_extension(".slvl").string();
+}
+
+std::string_view LevelData::getModelName(uint32_t model) const {
+    const ModelEntry& entry = m_modelView[model];
+    return m_nameView.substr(entry.m_nameOffset, entry.m_nameLength);
+}
+
+std::string_view LevelData::getMaterialName(uint32_t material) const {
+    const MaterialEntry& entry = m_materialView[material];
+    return m_nameView.substr(entry.m_nameOffset, entry.m_nameLength);
+}
+
+uint32_t LevelData::storeName(std::string_view name) {
+    uint32_t offset = uint32_t(m_names.size());
+    m_names.append(name);
+    return offset;
+}
+
+// Name tables hold a handful of entries, a linear search beats hashing here
+uint32_t LevelData::internModel(std::string_view name) {
+    for (size_t i = 0; i < m_models.size(); ++i)
+        if (std::string_view(m_names).substr(m_models[i].m_nameOffset, m_models[i].m_nameLength) == name)
+            return uint32_t(i);
+
+    ModelEntry entry{};
+    entry.m_nameOffset = storeName(name);
+    entry.m_nameLength = uint32_t(name.size());
+    m_models.push_back(entry);
+    return uint32_t(m_models.size() - 1);
+}
+
+uint32_t LevelData::internMaterial(std::string_view name) {
+    for (size_t i = 0; i < m_materials.size(); ++i)
+        if (std::string_view(m_names).substr(m_materials[i].m_nameOffset, m_materials[i].m_nameLength) == name)
+            return uint32_t(i);
+
+    MaterialEntry entry{};
+    entry.m_nameOffset = storeName(name);
+    entry.m_nameLength = uint32_t(name.size());
+    m_materials.push_back(entry);
+    return uint32_t(m_materials.size() - 1);
+}
+
+void LevelData::detach() {
+    if (!m_file.isOpen())
+        return;
+
+    m_names.assign(m_nameView);
+    m_models.assign(m_modelView.begin(), m_modelView.end());
+    m_materials.assign(m_materialView.begin(), m_materialView.end());
+    m_objects.assign(m_objectView.begin(), m_objectView.end());
+    m_lights.assign(m_lightView.begin(), m_lightView.end());
+    m_file.close();
+    refreshViews();
+}
+
+void LevelData::refreshViews() {
+    m_nameView     = m_names;
+    m_modelView    = m_models;
+    m_materialView = m_materials;
+    m_objectView   = m_objects;
+    m_lightView    = m_lights;
+}
+
+// Format: <id> <objectType> <textureName> px py pz rx ry rz sx sy sz
+// Moving objects (ids 8-11) may carry an end point after the scale, it is not used yet.
+bool LevelData::parseLevelText(const std::string& path) {
+    detach();
+    // The model and material tables are rebuilt from this level only
+    m_names.clear();
+    m_models.clear();
+    m_materials.clear();
+
+    VirtualFile file;
+    if (!VirtualFileSystem::map(path, file)) {
+        std::cerr << "LevelData: cannot open level " << path << "\n";
+        return false;
+    }
+
+    std::vector<Object> objects;
+    objects.reserve(128);
+
+    // Blank lines and '#' comments are skipped by the tokenizer
+    TextTokenizer tok(file.view());
+    while (tok.nextLine()) {
+        int              id;
+        std::string_view objectType, textureName;
+        float            px, py, pz, rx, ry, rz, sx, sy, sz;
+
+        bool ok = tok.next(id);
+        objectType  = tok.next();
+        textureName = tok.next();
+        ok = ok && !textureName.empty()
+            && tok.next(px) && tok.next(py) && tok.next(pz)
+            && tok.next(rx) && tok.next(ry) && tok.next(rz)
+            && tok.next(sx) && tok.next(sy) && tok.next(sz);
+        if (!ok) {
+            std::cerr << "LevelData: parse error in " << path << " at line "
+                << tok.lineNumber() << ": expected format:\n"
+                << "    <id> <objectType> <textureName> <px> <py> <pz> <rx> <ry> <rz> <sx> <sy> <sz>\n"
+                << "  got: \"" << tok.line() << "\"\n";
+            return false;
+        }
+
+        // World transform: T * Rx * Ry * Rz * S
+        LibMath::Matrix4 world = LibMath::Matrix4::identity();
+        world = world * LibMath::Matrix4::createTranslation(LibMath::Vector3(px, py, pz));
+        world = world * LibMath::Matrix4::createRotationX(LibMath::Degree(rx));
+        world = world * LibMath::Matrix4::createRotationY(LibMath::Degree(ry));
+        world = world * LibMath::Matrix4::createRotationZ(LibMath::Degree(rz));
+        world = world * LibMath::Matrix4::createScale(LibMath::Vector3(sx, sy, sz));
+
+        Object object{};
+        object.m_id       = id;
+        object.m_model    = internModel(objectType);
+        object.m_material = textureName == "none" ? k_none : internMaterial(textureName);
+        storeMatrix(world, object.m_world);
+        objects.push_back(object);
+    }
+
+    m_objects.swap(objects);
+    refreshViews();
+    return true;
+}
+
+// Format: <type> px py pz dx dy dz ar ag ab aa dr dg db da sr sg sb sa [c l q] [inner outer]
+bool LevelData::parseLightsText(const std::string& path) {
+    detach();
+
+    VirtualFile file;
+    if (!VirtualFileSystem::map(path, file)) {
+        std::cerr << "LevelData: cannot open lights " << path << "\n";
+        return false;
+    }
+
+    std::vector<Light> lights;
+
+    TextTokenizer tok(file.view());
+    while (tok.nextLine()) {
+        const int lineNo = tok.lineNumber();
+
+        std::string_view type = tok.next();
+        float px, py, pz, dx, dy, dz;
+        Light light{};
+        float* a = light.m_ambient;
+        float* d = light.m_diffuse;
+        float* s = light.m_specular;
+        float inner = 12.5f, outer = 17.5f;        // spot defaults in degrees
+        light.m_constant = 1.0f;                    // attenuation defaults
+
+        if (!(tok.next(px) && tok.next(py) && tok.next(pz)
+            && tok.next(dx) && tok.next(dy) && tok.next(dz)
+            && tok.next(a[0]) && tok.next(a[1]) && tok.next(a[2]) && tok.next(a[3])
+            && tok.next(d[0]) && tok.next(d[1]) && tok.next(d[2]) && tok.next(d[3])
+            && tok.next(s[0]) && tok.next(s[1]) && tok.next(s[2]) && tok.next(s[3]))) {
+            std::cerr << "Line " << lineNo << " parse error in " << path << "\n";
+            return false;
+        }
+
+        // Optional attenuation, kept at its defaults unless all three values are there
+        if (type != "directional") {
+            float c, l, q;
+            if (tok.next(c) && tok.next(l) && tok.next(q)) {
+                light.m_constant = c; light.m_linear = l; light.m_quadratic = q;
+            }
+        }
+
+        // Optional spot cutoffs
+        if (type == "spot") {
+            float i, o;
+            if (tok.next(i) && tok.next(o)) {
+                inner = i; outer = o;
+            }
+        }
+        light.m_cutOff      = LibMath::Degree(inner).radian();
+        light.m_outerCutOff = LibMath::Degree(outer).radian();
+
+        LibMath::Vector3 dir{ dx, dy, dz };
+        dir.normalize();
+
+        if (type == "directional") {
+            // -Z maps to (dx,dy,dz): a lookAt from the origin toward dir
+            light.m_type = LightType::Directional;
+            storeMatrix(LibMath::Matrix4::lookAt(LibMath::Vector3::zero(), dir, LibMath::Vector3::up()), light.m_transform);
+        }
+        else if (type == "point") {
+            light.m_type = LightType::Point;
+            storeMatrix(LibMath::Matrix4::createTranslation(LibMath::Vector3(px, py, pz)), light.m_transform);
+        }
+        else if (type == "spot") {
+            // Rotation pointing local -Z at the spot direction (lookAt degenerates along the up axis)
+            LibMath::Matrix4 R;
+            if (std::fabs(dir.dot(LibMath::Vector3(0, 1, 0))) < 0.99f)
+                R = LibMath::Matrix4::lookAt(LibMath::Vector3::zero(), dir, LibMath::Vector3::up());
+            else if (dir.dot(LibMath::Vector3(0, 1, 0)) < 0)
+                R = LibMath::Matrix4::createRotationX(LibMath::Degree(90.0f));
+            else
+                R = LibMath::Matrix4::createRotationX(LibMath::Degree(-90.0f));
+
+            light.m_type = LightType::Spot;
+            storeMatrix(LibMath::Matrix4::createTranslation(LibMath::Vector3{ px, py, pz }) * R, light.m_transform);
+        }
+        else {
+            std::cerr << "Unknown light type '" << type << "' at line " << lineNo << "\n";
+            return false;
+        }
+
+        lights.push_back(light);
+    }
+
+    m_lights.swap(lights);
+    refreshViews();
+    return true;
+}
+
+void LevelData::setModelBounds(uint32_t model, const LibMath::Prism3DAABB& localBounds) {
+    detach();
+    ModelEntry& entry = m_models[model];
+    entry.m_hasBounds = 1;
+    storeBounds(localBounds, entry.m_boundsMin, entry.m_boundsMax);
+}
+
+void LevelData::setObjectBounds(size_t object, const LibMath::Prism3DAABB& worldBounds) {
+    detach();
+    Object& entry = m_objects[object];
+    entry.m_hasBounds = 1;
+    storeBounds(worldBounds, entry.m_boundsMin, entry.m_boundsMax);
+}
+
+bool LevelData::loadCompiled(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath) {
+    if (!VirtualFileSystem::exists(slvlPath))
+        return false;
+
+    VirtualFile file;
+    if (!VirtualFileSystem::map(slvlPath, file) || file.size() < sizeof(SLevelHeader))
+        return false;
+
+    SLevelHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.m_magic != k_slvlMagic || header.m_version != k_slvlVersion ||
+        header.m_objectSize != sizeof(Object) || header.m_lightSize != sizeof(Light))
+        return false;
+
+    const size_t modelBytes    = size_t(header.m_modelCount) * sizeof(ModelEntry);
+    const size_t materialBytes = size_t(header.m_materialCount) * sizeof(MaterialEntry);
+    const size_t objectBytes   = size_t(header.m_objectCount) * sizeof(Object);
+    const size_t lightBytes    = size_t(header.m_lightCount) * sizeof(Light);
+    if (file.size() != sizeof(SLevelHeader) + modelBytes + materialBytes + objectBytes + lightBytes + header.m_nameBytes)
+        return false;
+
+    bool levelRetimed = false, lightsRetimed = false;
+    if (!header.m_levelSource.matches(levelPath, &levelRetimed) || !header.m_lightsSource.matches(lightsPath, &lightsRetimed))
+        return false;
+    if ((levelRetimed || lightsRetimed) && !file.isPacked()) {
+        // Same sources under new times: store the times, the next load then skips hashing them (best effort)
+        const size_t size = file.size();
+        file.close();
+        if (levelRetimed)
+            header.m_levelSource.rewrite(levelPath, slvlPath, offsetof(SLevelHeader, m_levelSource));
+        if (lightsRetimed)
+            header.m_lightsSource.rewrite(lightsPath, slvlPath, offsetof(SLevelHeader, m_lightsSource));
+        if (!VirtualFileSystem::map(slvlPath, file) || file.size() != size)
+            return false;
+    }
+
+    const char* data = file.data() + sizeof(SLevelHeader);
+    std::span<const ModelEntry>    models   { reinterpret_cast<const ModelEntry*>(data), header.m_modelCount };       data += modelBytes;
+    std::span<const MaterialEntry> materials{ reinterpret_cast<const MaterialEntry*>(data), header.m_materialCount }; data += materialBytes;
+    std::span<const Object>        objects  { reinterpret_cast<const Object*>(data), header.m_objectCount };          data += objectBytes;
+    std::span<const Light>         lights   { reinterpret_cast<const Light*>(data), header.m_lightCount };            data += lightBytes;
+    std::string_view               names    { data, header.m_nameBytes };
+
+    // Indices are trusted by the loaders, so a damaged file is rejected here once
+    for (const ModelEntry& entry : models)
+        if (size_t(entry.m_nameOffset) + entry.m_nameLength > names.size())
+            return false;
+    for (const MaterialEntry& entry : materials)
+        if (size_t(entry.m_nameOffset) + entry.m_nameLength > names.size())
+            return false;
+    for (const Object& object : objects)
+        if (object.m_model >= models.size() || (object.m_material != k_none && object.m_material >= materials.size()))
+            return false;
+    for (const Light& light : lights)
+        if (uint32_t(light.m_type) > uint32_t(LightType::Spot))
+            return false;
+
+    m_names.clear();
+    m_models.clear();
+    m_materials.clear();
+    m_objects.clear();
+    m_lights.clear();
+
+    m_file         = std::move(file);
+    m_nameView     = names;
+    m_modelView    = models;
+    m_materialView = materials;
+    m_objectView   = objects;
+    m_lightView    = lights;
+    return true;
+}
+
+bool LevelData::writeCompiled(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath) const {
+    SLevelHeader header{};
+    header.m_magic         = k_slvlMagic;
+    header.m_version       = k_slvlVersion;
+    header.m_objectSize    = sizeof(Object);
+    header.m_lightSize     = sizeof(Light);
+    if (!stampSource(levelPath, header.m_levelSource) || !stampSource(lightsPath, header.m_lightsSource)) {
+        std::cerr << "Cannot stamp level sources: " << levelPath << ", " << lightsPath << "\n";
+        return false;
+    }
+    header.m_modelCount    = uint32_t(m_modelView.size());
+    header.m_materialCount = uint32_t(m_materialView.size());
+    header.m_objectCount   = uint32_t(m_objectView.size());
+    header.m_lightCount    = uint32_t(m_lightView.size());
+    header.m_nameBytes     = uint32_t(m_nameView.size());
+
+    // Write to a temporary file first, a crash mid-write must not leave a valid-looking level
+    std::string tempPath = slvlPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Cannot write compiled level: " << slvlPath << "\n";
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(m_modelView.data()), std::streamsize(m_modelView.size_bytes()));
+        out.write(reinterpret_cast<const char*>(m_materialView.data()), std::streamsize(m_materialView.size_bytes()));
+        out.write(reinterpret_cast<const char*>(m_objectView.data()), std::streamsize(m_objectView.size_bytes()));
+        out.write(reinterpret_cast<const char*>(m_lightView.data()), std::streamsize(m_lightView.size_bytes()));
+        out.write(m_nameView.data(), std::streamsize(m_nameView.size()));
+        if (!out) {
+            std::cerr << "Cannot write compiled level: " << slvlPath << "\n";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, slvlPath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        std::cerr << "Cannot write compiled level: " << slvlPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool LevelData::compile(const std::string& slvlPath, const std::string& levelPath, const std::string& lightsPath,
+                        const std::map<std::string, std::string, std::less<>>& modelMeshes, std::vector<std::string>* outMeshes) {
+    if (!parseLevelText(levelPath) || !parseLightsText(lightsPath))
+        return false;
+
+    // Parse each referenced model once (CPU only, the tools have no GL context)
+    std::vector<std::vector<Vertex>> vertices(getModels().size());
+    for (uint32_t i = 0; i < getModels().size(); ++i) {
+        std::string_view name = getModelName(i);
+        auto path = modelMeshes.find(name);
+        if (path == modelMeshes.end()) {
+            std::cerr << "LevelData: no mesh for model \"" << name << "\" in " << levelPath << "\n";
+            return false;
+        }
+
+        VirtualFile file;
+        std::vector<uint32_t> indices;
+        if (!VirtualFileSystem::map(path->second, file) || !Model::parseOBJ(file.view(), vertices[i], indices) || vertices[i].empty()) {
+            std::cerr << "LevelData: cannot load mesh " << path->second << " for model \"" << name << "\"\n";
+            return false;
+        }
+        if (outMeshes)
+            outMeshes->push_back(path->second);
+        setModelBounds(i, localBounds(vertices[i]));
+    }
+
+    for (size_t i = 0; i < getObjects().size(); ++i) {
+        const Object& object = getObjects()[i];
+        setObjectBounds(i, worldBounds(vertices[object.m_model], toMatrix(object.m_world)));
+    }
+    return writeCompiled(slvlPath, levelPath, lightsPath);
+}
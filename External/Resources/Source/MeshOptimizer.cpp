@@ -0,0 +1,484 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t k_noVertex = 0xFFFFFFFFu;
+
+    // FIFO cache of vertex indices: a vertex is a hit while fewer than cacheSize misses happened since it entered
+    class CacheSimulator {
+    public:
+        CacheSimulator(size_t vertexCount, size_t cacheSize)
+            : m_entered(vertexCount, 0), m_cacheSize(cacheSize) {}
+
+        bool access(uint32_t vertex) {
+            if (m_entered[vertex] != 0 && m_time - m_entered[vertex] < m_cacheSize)
+                return true;
+            m_entered[vertex] = ++m_time;
+            return false;
+        }
+
+        void reset() {
+            std::fill(m_entered.begin(), m_entered.end(), 0);
+            m_time = 0;
+        }
+
+    private:
+        std::vector<size_t> m_entered;  // Miss count when the vertex last entered, 0 if never
+        size_t              m_time = 0;
+        size_t              m_cacheSize;
+    };
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    Report report;
+    report.m_acmrBefore = computeACMR(indices, vertices.size());
+
+    std::vector<uint32_t> clusters;
+    optimizeVertexCache(indices, vertices.size(), clusters);
+    if (optimizeOverdraw(indices, vertices, clusters))
+        report.m_clusterCount = clusters.size();
+    optimizeVertexFetch(vertices, indices);
+
+    report.m_acmrAfter = computeACMR(indices, vertices.size());
+    return report;
+}
+
+// Tipsify: fan around a vertex, then move to the neighbour that is still in the cache and has the fewest
+// live triangles left, falling back to recently used vertices (dead ends) and then to the input order.
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& outClusters) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // Vertex -> triangles adjacency, stored as one array with per-vertex offsets
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++offsets[indices[i] + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+
+    std::vector<uint32_t> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        live[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<size_t>   cacheTime(vertexCount, 0);
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    std::vector<uint32_t> boundaries;
+    output.reserve(triangleCount * 3);
+
+    size_t   time = k_cacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fan = 0;
+
+    auto skipDeadEnd = [&]() -> uint32_t {
+        while (!deadEnds.empty()) {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v] > 0)
+                return v;
+        }
+        while (cursor < vertexCount) {
+            if (live[cursor] > 0)
+                return cursor;
+            ++cursor;
+        }
+        return k_noVertex;
+    };
+
+    while (fan != k_noVertex) {
+        candidates.clear();
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t v = indices[triangle * 3 + corner];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cacheTime[v] > k_cacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that entered the cache earliest but will still be in it after its fan
+        uint32_t next = k_noVertex;
+        size_t bestPriority = 0;
+        bool found = false;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0)
+                continue;
+            size_t priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= k_cacheSize)
+                priority = time - cacheTime[v];
+            if (!found || priority > bestPriority) {
+                next = v;
+                bestPriority = priority;
+                found = true;
+            }
+        }
+        if (!found) {
+            next = skipDeadEnd();
+            if (next != k_noVertex)
+                boundaries.push_back(uint32_t(output.size() / 3));
+        }
+        fan = next;
+    }
+
+    // Only keep the boundaries where the cluster so far is cache friendly on its own (cold cache), so
+    // drawing the clusters in another order costs little
+    const float acmr = computeACMR(output, vertexCount);
+    CacheSimulator cache(vertexCount, k_cacheSize);
+    size_t clusterStart = 0, misses = 0, nextBoundary = 0;
+    outClusters.push_back(0);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (nextBoundary < boundaries.size() && boundaries[nextBoundary] == t) {
+            ++nextBoundary;
+            if (t > clusterStart && float(misses) / float(t - clusterStart) <= acmr * k_overdrawThreshold) {
+                outClusters.push_back(uint32_t(t));
+                clusterStart = t;
+                misses = 0;
+                cache.reset();
+            }
+        }
+        for (int corner = 0; corner < 3; ++corner)
+            misses += cache.access(output[t * 3 + corner]) ? 0 : 1;
+    }
+
+    indices.swap(output);
+}
+
+// Clusters on the outside of the mesh, facing away from its centre, are likely to occlude the others
+bool MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters) {
+    const size_t triangleCount = indices.size() / 3;
+    if (clusters.size() < 2 || triangleCount == 0)
+        return false;
+
+    struct Cluster {
+        uint32_t            m_begin, m_end;
+        LibMath::Vector3    m_centroid;     // Area weighted
+        LibMath::Vector3    m_normal;       // Area weighted sum of the face normals
+        float               m_area = 0.0f;
+        float               m_sortKey = 0.0f;
+    };
+
+    std::vector<Cluster> sorted(clusters.size());
+    LibMath::Vector3 meshCentroid;
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster& cluster = sorted[c];
+        cluster.m_begin = clusters[c];
+        cluster.m_end = c + 1 < clusters.size() ? clusters[c + 1] : uint32_t(triangleCount);
+
+        for (uint32_t t = cluster.m_begin; t < cluster.m_end; ++t) {
+            const LibMath::Vector3& a = vertices[indices[t * 3 + 0]].m_position;
+            const LibMath::Vector3& b = vertices[indices[t * 3 + 1]].m_position;
+            const LibMath::Vector3& p = vertices[indices[t * 3 + 2]].m_position;
+            LibMath::Vector3 normal = (b - a).cross(p - a);
+            float area = normal.magnitude() * 0.5f;
+            cluster.m_centroid += (a + b + p) * (area / 3.0f);
+            cluster.m_normal += normal;
+            cluster.m_area += area;
+        }
+        meshCentroid += cluster.m_centroid;
+        meshArea += cluster.m_area;
+        if (cluster.m_area > 0.0f)
+            cluster.m_centroid = cluster.m_centroid / cluster.m_area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid = meshCentroid / meshArea;
+
+    for (Cluster& cluster : sorted) {
+        float length = cluster.m_normal.magnitude();
+        cluster.m_sortKey = length > 0.0f ? (cluster.m_centroid - meshCentroid).dot(cluster.m_normal) / length : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.m_sortKey > b.m_sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : sorted)
+        output.insert(output.end(), indices.begin() + cluster.m_begin * 3, indices.begin() + cluster.m_end * 3);
+
+    if (computeACMR(output, vertices.size()) > computeACMR(indices, vertices.size()) * k_overdrawThreshold)
+        return false;
+
+    indices.swap(output);
+    return true;
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::vector<uint32_t> remap(vertices.size(), k_noVertex);
+    std::vector<Vertex> output;
+    output.reserve(vertices.size());
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == k_noVertex) {
+            remap[index] = uint32_t(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+namespace {
+    // Sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland & Heckbert
+    struct Quadric {
+        double m_a2 = 0, m_ab = 0, m_ac = 0, m_ad = 0, m_b2 = 0, m_bc = 0, m_bd = 0, m_c2 = 0, m_cd = 0, m_d2 = 0;
+
+        static Quadric fromPlane(double a, double b, double c, double d) {
+            return { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+        }
+
+        Quadric& operator+=(const Quadric& q) {
+            m_a2 += q.m_a2; m_ab += q.m_ab; m_ac += q.m_ac; m_ad += q.m_ad; m_b2 += q.m_b2;
+            m_bc += q.m_bc; m_bd += q.m_bd; m_c2 += q.m_c2; m_cd += q.m_cd; m_d2 += q.m_d2;
+            return *this;
+        }
+
+        double evaluate(const LibMath::Vector3& p) const {
+            const double x = p.m_x, y = p.m_y, z = p.m_z;
+            double error = m_a2 * x * x + 2 * m_ab * x * y + 2 * m_ac * x * z + 2 * m_ad * x
+                         + m_b2 * y * y + 2 * m_bc * y * z + 2 * m_bd * y
+                         + m_c2 * z * z + 2 * m_cd * z + m_d2;
+            return error > 0.0 ? error : 0.0;
+        }
+    };
+
+    struct Collapse {
+        double      m_cost;
+        uint32_t    m_from, m_to;
+        uint32_t    m_fromVersion, m_toVersion;
+
+        bool operator>(const Collapse& other) const { return m_cost > other.m_cost; }
+    };
+}
+
+float MeshOptimizer::simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                              size_t targetTriangleCount, float maxError, std::vector<uint32_t>& outIndices) {
+    outIndices.clear();
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+
+    // 1) Weld by position: the collapses work on positions, the attributes follow at the end
+    std::vector<uint32_t> positionOf(vertices.size());
+    std::vector<LibMath::Vector3> positions;
+    std::vector<std::vector<uint32_t>> verticesAt;
+    {
+        struct PositionHash {
+            size_t operator()(const LibMath::Vector3& p) const {
+                uint32_t bits[3];
+                std::memcpy(bits, &p.m_x, sizeof(float));
+                std::memcpy(bits + 1, &p.m_y, sizeof(float));
+                std::memcpy(bits + 2, &p.m_z, sizeof(float));
+                return (size_t(bits[0]) * 73856093u) ^ (size_t(bits[1]) * 19349663u) ^ (size_t(bits[2]) * 83492791u);
+            }
+        };
+        struct PositionEqual {
+            bool operator()(const LibMath::Vector3& a, const LibMath::Vector3& b) const {
+                return a.m_x == b.m_x && a.m_y == b.m_y && a.m_z == b.m_z;
+            }
+        };
+        std::unordered_map<LibMath::Vector3, uint32_t, PositionHash, PositionEqual> welded;
+        welded.reserve(vertices.size());
+        for (size_t v = 0; v < vertices.size(); ++v) {
+            auto [it, inserted] = welded.try_emplace(vertices[v].m_position, uint32_t(positions.size()));
+            if (inserted) {
+                positions.push_back(vertices[v].m_position);
+                verticesAt.emplace_back();
+            }
+            positionOf[v] = it->second;
+            verticesAt[it->second].push_back(uint32_t(v));
+        }
+    }
+    const size_t positionCount = positions.size();
+
+    // 2) Triangles over positions, plane quadrics, and the positions on an open border (locked)
+    std::vector<uint32_t> triangles(triangleCount * 3);
+    std::vector<bool> alive(triangleCount, false);
+    std::vector<Quadric> quadrics(positionCount);
+    std::vector<std::vector<uint32_t>> trianglesAt(positionCount);
+    std::unordered_map<uint64_t, int> edgeUse;
+    size_t aliveCount = 0;
+
+    auto edgeKey = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint32_t p[3] = { positionOf[indices[t * 3]], positionOf[indices[t * 3 + 1]], positionOf[indices[t * 3 + 2]] };
+        if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2])
+            continue;
+
+        LibMath::Vector3 normal = (positions[p[1]] - positions[p[0]]).cross(positions[p[2]] - positions[p[0]]);
+        float length = normal.magnitude();
+        if (length > 0.0f) {
+            normal = normal / length;
+            Quadric plane = Quadric::fromPlane(normal.m_x, normal.m_y, normal.m_z, -double(normal.dot(positions[p[0]])));
+            for (uint32_t corner : p)
+                quadrics[corner] += plane;
+        }
+
+        for (int c = 0; c < 3; ++c) {
+            triangles[t * 3 + c] = p[c];
+            trianglesAt[p[c]].push_back(uint32_t(t));
+            ++edgeUse[edgeKey(p[c], p[(c + 1) % 3])];
+        }
+        alive[t] = true;
+        ++aliveCount;
+    }
+
+    std::vector<bool> locked(positionCount, false);
+    for (const auto& [key, count] : edgeUse) {
+        if (count == 1) {
+            locked[uint32_t(key >> 32)] = true;
+            locked[uint32_t(key)] = true;
+        }
+    }
+
+    // 3) Cheapest collapse first; entries made stale by later collapses are skipped when popped
+    std::vector<uint32_t> version(positionCount, 0);
+    std::vector<uint32_t> remap(positionCount);
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    auto pushEdge = [&](uint32_t a, uint32_t b) {
+        Quadric sum = quadrics[a];
+        sum += quadrics[b];
+        double costAB = locked[a] ? -1.0 : sum.evaluate(positions[b]);
+        double costBA = locked[b] ? -1.0 : sum.evaluate(positions[a]);
+        if (costAB < 0.0 && costBA < 0.0)
+            return;
+        if (costBA < 0.0 || (costAB >= 0.0 && costAB <= costBA))
+            queue.push({ costAB, a, b, version[a], version[b] });
+        else
+            queue.push({ costBA, b, a, version[b], version[a] });
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!alive[t])
+            continue;
+        for (int c = 0; c < 3; ++c) {
+            uint32_t a = triangles[t * 3 + c], b = triangles[t * 3 + (c + 1) % 3];
+            if (a < b)
+                pushEdge(a, b);
+        }
+    }
+
+    const double maxCost = double(maxError) * double(maxError);
+    double reached = 0.0;
+    while (aliveCount > targetTriangleCount && !queue.empty()) {
+        Collapse collapse = queue.top();
+        queue.pop();
+        const uint32_t from = collapse.m_from, to = collapse.m_to;
+        if (remap[from] != from || remap[to] != to || version[from] != collapse.m_fromVersion || version[to] != collapse.m_toVersion)
+            continue;
+        if (collapse.m_cost > maxCost)
+            break;
+
+        // Moving "from" onto "to" must not turn any remaining triangle over
+        bool flips = false;
+        for (uint32_t t : trianglesAt[from]) {
+            if (!alive[t])
+                continue;
+            const uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+            LibMath::Vector3 p[3], moved[3];
+            for (int c = 0; c < 3; ++c) {
+                p[c] = positions[tri[c]];
+                moved[c] = tri[c] == from ? positions[to] : p[c];
+            }
+            LibMath::Vector3 before = (p[1] - p[0]).cross(p[2] - p[0]);
+            LibMath::Vector3 after = (moved[1] - moved[0]).cross(moved[2] - moved[0]);
+            if (before.dot(after) <= 0.0f) {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        remap[from] = to;
+        quadrics[to] += quadrics[from];
+        ++version[to];
+        reached = std::max(reached, collapse.m_cost);
+
+        for (uint32_t t : trianglesAt[from]) {
+            if (!alive[t])
+                continue;
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                alive[t] = false;
+                --aliveCount;
+                continue;
+            }
+            for (int c = 0; c < 3; ++c)
+                if (tri[c] == from)
+                    tri[c] = to;
+            trianglesAt[to].push_back(t);
+        }
+        std::vector<uint32_t>().swap(trianglesAt[from]);
+
+        for (uint32_t t : trianglesAt[to]) {
+            if (!alive[t])
+                continue;
+            for (int c = 0; c < 3; ++c)
+                if (triangles[t * 3 + c] != to)
+                    pushEdge(to, triangles[t * 3 + c]);
+        }
+    }
+
+    // 4) Back to vertices: a corner that moved takes the closest-normal vertex at its new position
+    std::unordered_map<uint64_t, uint32_t> moved;
+    auto vertexFor = [&](uint32_t original, uint32_t position) {
+        if (positionOf[original] == position)
+            return original;
+        auto [it, inserted] = moved.try_emplace((uint64_t(original) << 32) | position, 0u);
+        if (inserted) {
+            const LibMath::Vector3& normal = vertices[original].m_normal;
+            float best = -2.0f;
+            for (uint32_t candidate : verticesAt[position]) {
+                float match = vertices[candidate].m_normal.dot(normal);
+                if (match > best) {
+                    best = match;
+                    it->second = candidate;
+                }
+            }
+        }
+        return it->second;
+    };
+
+    outIndices.reserve(aliveCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!alive[t])
+            continue;
+        for (int c = 0; c < 3; ++c)
+            outIndices.push_back(vertexFor(indices[t * 3 + c], triangles[t * 3 + c]));
+    }
+    return float(std::sqrt(reached));
+}
+
+float MeshOptimizer::computeACMR(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize) {
+    if (indices.size() < 3)
+        return 0.0f;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (uint32_t index : indices)
+        misses += cache.access(index) ? 0 : 1;
+    return float(misses) / float(indices.size() / 3);
+}
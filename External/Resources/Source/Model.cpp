@@ -1,38 +1,45 @@
 #include "Model.h"
-#include <fstream>
+#include "VirtualFileSystem.h"
+#include "MeshOptimizer.h"
+#include "TextTokenizer.h"
+#include "SourceStamp.h"
 #include <iostream>
-#include <sstream>
+#include <fstream>
+#include <filesystem>
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <limits>
 
 // --- Model destructor ---
 Model::~Model() = default;
 
 // --- GPU Buffer implementations ---
-Model::Buffer::Buffer(GLenum type) : m_type(type) {
-    glGenBuffers(1, &m_id);
-}
+// The GL objects are created on first use, on the GL thread: a Model can be built and cooked without a context
+Model::Buffer::Buffer(GLenum type) : m_type(type) {}
 Model::Buffer::~Buffer() {
     if (m_id) glDeleteBuffers(1, &m_id);
 }
 void Model::Buffer::bind() const {
+    if (!m_id) glGenBuffers(1, &m_id);
     glBindBuffer(m_type, m_id);
 }
 void Model::Buffer::unbind() const {
     glBindBuffer(m_type, 0);
 }
 void Model::Buffer::setData(GLsizeiptr size, const void* data, GLenum usage) {
-    glBindBuffer(m_type, m_id);
+    bind();
     glBufferData(m_type, size, data, usage);
 }
 
 // --- VertexAttributes implementations ---
-Model::VertexAttributes::VertexAttributes() {
-    glGenVertexArrays(1, &m_id);
-}
+Model::VertexAttributes::VertexAttributes() {}
 Model::VertexAttributes::~VertexAttributes() {
     if (m_id) glDeleteVertexArrays(1, &m_id);
 }
 void Model::VertexAttributes::bind() const {
+    if (!m_id) glGenVertexArrays(1, &m_id);
     glBindVertexArray(m_id);
 }
 void Model::VertexAttributes::unbind() const {
@@ -41,200 +48,684 @@ void Model::VertexAttributes::unbind() const {
 
 // --- uploadToGPU & draw ---
 void Model::uploadToGPU() {
-    if (m_isUploaded || m_vertices.empty() || m_indices.empty()) return;
+    if (m_isUploaded || m_vertexView.empty() || m_indexView.empty()) return;
+
+    // Straight from the parsed vectors or the mapped cache file, or the compressed copy
+    const bool packed = !m_packedVertices.empty();
+    const size_t vertexBytes = packed ? m_packedVertices.size() * sizeof(PackedVertex) : m_vertexView.size_bytes();
+
+    // Half the index bandwidth whenever every index fits in 16 bits
+    std::vector<uint16_t> shortIndices;
+    if (m_vertexView.size() <= k_maxShortIndexVertices)
+        shortIndices.assign(m_indexView.begin(), m_indexView.end());
+    m_indexType = shortIndices.empty() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    const size_t indexBytes = shortIndices.empty() ? m_indexView.size_bytes() : shortIndices.size() * sizeof(uint16_t);
 
     m_vao.bind();
     m_vbo.setData(
-        GLsizeiptr(m_vertices.size() * sizeof(Vertex)),
-        m_vertices.data(),
+        GLsizeiptr(vertexBytes),
+        packed ? static_cast<const void*>(m_packedVertices.data()) : m_vertexView.data(),
         GL_STATIC_DRAW
     );
     m_ebo.setData(
-        GLsizeiptr(m_indices.size() * sizeof(uint32_t)),
-        m_indices.data(),
+        GLsizeiptr(indexBytes),
+        shortIndices.empty() ? static_cast<const void*>(m_indexView.data()) : shortIndices.data(),
         GL_STATIC_DRAW
     );
 
-    // Position
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE,
-        GLsizei(sizeof(Vertex)),
-        (void*)offsetof(Vertex, m_position)
-    );
-
-    // Normal
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(
-        1, 3, GL_FLOAT, GL_FALSE,
-        GLsizei(sizeof(Vertex)),
-        (void*)offsetof(Vertex, m_normal)
-    );
-
-    // UV
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(
-        2, 2, GL_FLOAT, GL_FALSE,
-        GLsizei(sizeof(Vertex)),
-        (void*)offsetof(Vertex, m_uv)
-    );
+    if (packed) {
+        // Normalized integers reach the shader as floats: position in [0,1], normal in [-1,1]
+        const GLsizei stride = GLsizei(sizeof(PackedVertex));
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_position));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, m_uv));
+    }
+    else {
+        const GLsizei stride = GLsizei(sizeof(Vertex));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, m_position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, m_normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, m_uv));
+    }
 
     m_vao.unbind();
+    m_gpuBytes = vertexBytes + indexBytes;
     m_isUploaded = true;
+
+    // The compressed copy only existed for the upload. The float vertices stay for the colliders,
+    // unless they were given a proxy
+    std::vector<PackedVertex>().swap(m_packedVertices);
+    if (s_residency == Residency::GpuOnly)
+        releaseGeometry();
 }
 
-void Model::draw() const {
-    if (!m_isUploaded) return;
+bool Model::evict() {
+    if (!m_isUploaded || m_sourcePath.empty()) return false;
+
+    // Keep the GL objects, drop their storage
     m_vao.bind();
-    glDrawElements(
+    m_vbo.setData(0, nullptr, GL_STATIC_DRAW);
+    m_ebo.setData(0, nullptr, GL_STATIC_DRAW);
+    m_vao.unbind();
+    m_gpuBytes = 0;
+    m_isUploaded = false;
+
+    std::vector<Vertex>().swap(m_vertices);
+    std::vector<uint32_t>().swap(m_indices);
+    m_cacheFile.close();
+    m_vertexView = {};
+    m_indexView  = {};
+    m_lodCount   = 0;
+    m_collisionProxy.clear();
+    return true;
+}
+
+bool Model::restore() {
+    if (!loadFromOBJ(m_sourcePath)) {
+        std::cerr << "Cannot restore model: " << m_sourcePath << "\n";
+        return false;
+    }
+    uploadToGPU();
+    return m_isUploaded;
+}
+
+void Model::drawInstanced(size_t lod, GLuint instanceBuffer, size_t byteOffset, GLsizei count) const {
+    if (!m_isUploaded || m_lodCount == 0 || count <= 0) return;
+    const Lod& level = m_lods[std::min(lod, m_lodCount - 1)];
+    const size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    m_vao.bind();
+
+    // No base instance in GL 3.3: the instance attributes are pointed at this group's slice for every draw
+    const GLsizei stride = GLsizei(sizeof(InstanceData));
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (GLuint column = 0; column < 4; ++column) {
+        const GLuint location = k_instanceAttribute + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + offsetof(InstanceData, m_model) + column * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+    for (GLuint column = 0; column < 3; ++column) {
+        const GLuint location = k_instanceAttribute + 4 + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + offsetof(InstanceData, m_normal) + column * 3 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDrawElementsInstanced(
         GL_TRIANGLES,
-        GLsizei(m_indices.size()),
-        GL_UNSIGNED_INT,
-        nullptr
+        GLsizei(level.m_indexCount),
+        m_indexType,
+        reinterpret_cast<const void*>(size_t(level.m_indexOffset) * indexSize),
+        count
     );
     m_vao.unbind();
 }
 
+// --- .smesh cache ---
+namespace {
+    constexpr uint32_t k_smeshMagic   = 0x48534D53; // "SMSH"
+    constexpr uint32_t k_smeshVersion = 3;   // 2: triangles and vertices in MeshOptimizer order, 3: LODs
+
+    // File layout: header, vertexCount Vertex, indexCount uint32_t (every LOD, one after the other).
+    // The header is a multiple of 16 bytes so the vertex array stays aligned in the mapping.
+    struct SMeshHeader {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_vertexStride;    // sizeof(Vertex) when written, rejects layout changes
+        uint32_t m_indexSize;
+        SourceStamp m_source;       // Source the cache was built from
+        uint32_t m_vertexCount;
+        uint32_t m_indexCount;
+        float    m_boundsMin[3];
+        float    m_boundsMax[3];
+        float    m_sphere[4];       // center xyz, radius
+        uint32_t m_lodCount;
+        uint32_t m_padding;
+        Model::Lod m_lods[Model::k_maxLods];
+    };
+    static_assert(sizeof(SMeshHeader) % 16 == 0, "SMeshHeader must keep the vertex data aligned");
+}
+
+std::string Model::cachePathFor(const std::string& objPath) {
+    return std::filesystem::path(objPath).replace_extension(".smesh").string();
+}
+
+bool Model::loadCache(const std::string& cachePath, const std::string& sourcePath) {
+    if (!VirtualFileSystem::exists(cachePath))
+        return false;
+
+    VirtualFile cache;
+    if (!VirtualFileSystem::map(cachePath, cache) || cache.size() < sizeof(SMeshHeader))
+        return false;
+
+    SMeshHeader header;
+    std::memcpy(&header, cache.data(), sizeof(header));
+    if (header.m_magic != k_smeshMagic || header.m_version != k_smeshVersion ||
+        header.m_vertexStride != sizeof(Vertex) || header.m_indexSize != sizeof(uint32_t))
+        return false;
+
+    size_t expected = sizeof(SMeshHeader) + size_t(header.m_vertexCount) * sizeof(Vertex) + size_t(header.m_indexCount) * sizeof(uint32_t);
+    if (cache.size() != expected)
+        return false;
+
+    if (header.m_lodCount == 0 || header.m_lodCount > k_maxLods)
+        return false;
+    for (uint32_t i = 0; i < header.m_lodCount; ++i) {
+        const Lod& lod = header.m_lods[i];
+        if (lod.m_indexCount == 0 || lod.m_indexCount % 3 != 0 || size_t(lod.m_indexOffset) + lod.m_indexCount > header.m_indexCount)
+            return false;
+    }
+
+    bool retimed = false;
+    if (!header.m_source.matches(sourcePath, &retimed))
+        return false;
+    if (retimed && !cache.isPacked()) {
+        // Same source under a new time: store the time, the next load then skips hashing the source.
+        // A cache that cannot be written is still valid, it is just hashed again next time.
+        cache.close();
+        header.m_source.rewrite(sourcePath, cachePath, offsetof(SMeshHeader, m_source));
+        if (!VirtualFileSystem::map(cachePath, cache) || cache.size() != expected)
+            return false;
+    }
+
+    const char* data = cache.data() + sizeof(SMeshHeader);
+    m_vertexView = { reinterpret_cast<const Vertex*>(data), header.m_vertexCount };
+    m_indexView  = { reinterpret_cast<const uint32_t*>(data + header.m_vertexCount * sizeof(Vertex)), header.m_indexCount };
+    m_bounds = LibMath::Prism3DAABB(
+        LibMath::Point3D(header.m_boundsMin[0], header.m_boundsMin[1], header.m_boundsMin[2]),
+        LibMath::Point3D(header.m_boundsMax[0], header.m_boundsMax[1], header.m_boundsMax[2]));
+    m_boundingSphere = LibMath::Sphere3D(
+        LibMath::Point3D(header.m_sphere[0], header.m_sphere[1], header.m_sphere[2]), header.m_sphere[3]);
+    std::copy_n(header.m_lods, header.m_lodCount, m_lods);
+    m_lodCount = header.m_lodCount;
+
+    m_vertices.clear();
+    m_indices.clear();
+    m_cacheFile = std::move(cache);
+    return true;
+}
+
+bool Model::writeCache(const std::string& cachePath, const std::string& sourcePath, std::string_view sourceText) const {
+    SMeshHeader header{};
+    header.m_magic        = k_smeshMagic;
+    header.m_version      = k_smeshVersion;
+    header.m_vertexStride = sizeof(Vertex);
+    header.m_indexSize    = sizeof(uint32_t);
+    if (!SourceStamp::make(sourcePath, sourceText, header.m_source))
+        return false;
+    header.m_vertexCount  = uint32_t(m_vertexView.size());
+    header.m_indexCount   = uint32_t(m_indexView.size());
+
+    LibMath::Point3D min = m_bounds.getMin(), max = m_bounds.getMax(), center = m_boundingSphere.getCenter();
+    header.m_boundsMin[0] = min.getX();    header.m_boundsMin[1] = min.getY();    header.m_boundsMin[2] = min.getZ();
+    header.m_boundsMax[0] = max.getX();    header.m_boundsMax[1] = max.getY();    header.m_boundsMax[2] = max.getZ();
+    header.m_sphere[0]    = center.getX(); header.m_sphere[1]    = center.getY(); header.m_sphere[2]    = center.getZ();
+    header.m_sphere[3]    = m_boundingSphere.getRadius();
+    header.m_lodCount     = uint32_t(m_lodCount);
+    std::copy_n(m_lods, m_lodCount, header.m_lods);
+
+    // Write to a temporary file first, a crash mid-write must not leave a valid-looking cache
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Cannot write mesh cache: " << cachePath << "\n";
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(m_vertexView.data()), std::streamsize(m_vertexView.size_bytes()));
+        out.write(reinterpret_cast<const char*>(m_indexView.data()), std::streamsize(m_indexView.size_bytes()));
+        if (!out) {
+            std::cerr << "Cannot write mesh cache: " << cachePath << "\n";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        std::cerr << "Cannot write mesh cache: " << cachePath << "\n";
+        return false;
+    }
+    return true;
+}
+
+void Model::computeBounds() {
+    if (m_vertexView.empty()) {
+        m_bounds = LibMath::Prism3DAABB();
+        m_boundingSphere = LibMath::Sphere3D();
+        return;
+    }
+
+    LibMath::Vector3 min = m_vertexView[0].m_position, max = min;
+    for (const Vertex& v : m_vertexView) {
+        min = LibMath::Vector3(std::min(min.m_x, v.m_position.m_x), std::min(min.m_y, v.m_position.m_y), std::min(min.m_z, v.m_position.m_z));
+        max = LibMath::Vector3(std::max(max.m_x, v.m_position.m_x), std::max(max.m_y, v.m_position.m_y), std::max(max.m_z, v.m_position.m_z));
+    }
+    m_bounds = LibMath::Prism3DAABB(LibMath::Point3D(min.m_x, min.m_y, min.m_z), LibMath::Point3D(max.m_x, max.m_y, max.m_z));
+
+    // Sphere around the box centre, tightened to the farthest vertex
+    LibMath::Vector3 center = (min + max) * 0.5f;
+    float radiusSq = 0.0f;
+    for (const Vertex& v : m_vertexView)
+        radiusSq = std::max(radiusSq, (v.m_position - center).magnitudeSquared());
+    m_boundingSphere = LibMath::Sphere3D(LibMath::Point3D(center.m_x, center.m_y, center.m_z), std::sqrt(radiusSq));
+}
+
+// --- Compressed vertices ---
+namespace {
+    // float -> IEEE half, round to nearest even, overflow to infinity
+    uint16_t toHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+        if (absBits >= 0x7F800000u)     // Inf or NaN
+            return uint16_t(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));
+        if (absBits >= 0x477FF000u)     // Rounds past the largest half
+            return uint16_t(sign | 0x7C00u);
+        if (absBits < 0x38800000u) {    // Subnormal half (or zero)
+            if (absBits < 0x33000000u)
+                return uint16_t(sign);
+            const uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+            const int shift = 126 - int(absBits >> 23);
+            uint32_t half = mantissa >> shift;
+            const uint32_t rest = mantissa & ((1u << shift) - 1u);
+            const uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1u)))
+                ++half;
+            return uint16_t(sign | half);
+        }
+
+        uint32_t half = ((absBits - 0x38000000u) >> 13);
+        const uint32_t rest = absBits & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+            ++half;
+        return uint16_t(sign | half);
+    }
+
+    float fromHalf(uint16_t half) {
+        const uint32_t sign = uint32_t(half & 0x8000u) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1Fu;
+        const uint32_t mantissa = half & 0x3FFu;
+        float value;
+        if (exponent == 0)
+            value = std::ldexp(float(mantissa), -24);
+        else if (exponent == 31)
+            value = mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+        else
+            value = std::ldexp(float(mantissa | 0x400u), int(exponent) - 25);
+        return sign ? -value : value;
+    }
+
+    // Octahedral mapping of a unit vector onto [-1,1]^2 (lower hemisphere folded over the diagonals)
+    void encodeOctahedral(const LibMath::Vector3& n, int16_t (&out)[2]) {
+        const float l1 = std::fabs(n.m_x) + std::fabs(n.m_y) + std::fabs(n.m_z);
+        float x = l1 > 0.0f ? n.m_x / l1 : 0.0f;
+        float y = l1 > 0.0f ? n.m_y / l1 : 0.0f;
+        if (n.m_z < 0.0f) {
+            const float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        out[0] = int16_t(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+        out[1] = int16_t(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    // Same decode as LightsVert.glsl
+    LibMath::Vector3 decodeOctahedral(const int16_t (&in)[2]) {
+        const float x = std::max(float(in[0]) / 32767.0f, -1.0f);
+        const float y = std::max(float(in[1]) / 32767.0f, -1.0f);
+        LibMath::Vector3 n(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+        const float t = std::max(-n.m_z, 0.0f);
+        n.m_x += n.m_x >= 0.0f ? -t : t;
+        n.m_y += n.m_y >= 0.0f ? -t : t;
+        n.normalize();
+        return n;
+    }
+}
+
+void Model::packVertices() {
+    const LibMath::Point3D min = m_bounds.getMin(), max = m_bounds.getMax();
+    m_positionOffset = LibMath::Vector3(min.getX(), min.getY(), min.getZ());
+    m_positionScale  = LibMath::Vector3(max.getX() - min.getX(), max.getY() - min.getY(), max.getZ() - min.getZ());
+
+    auto quantize = [](float value, float offset, float extent) {
+        return extent > 0.0f ? uint16_t(std::lround(std::clamp((value - offset) / extent, 0.0f, 1.0f) * 65535.0f)) : uint16_t(0);
+    };
+    auto dequantize = [](uint16_t value, float offset, float extent) {
+        return float(value) / 65535.0f * extent + offset;
+    };
+
+    CompressionReport report;
+    m_packedVertices.resize(m_vertexView.size());
+    for (size_t i = 0; i < m_vertexView.size(); ++i) {
+        const Vertex& v = m_vertexView[i];
+        PackedVertex& p = m_packedVertices[i];
+
+        p.m_position[0] = quantize(v.m_position.m_x, m_positionOffset.m_x, m_positionScale.m_x);
+        p.m_position[1] = quantize(v.m_position.m_y, m_positionOffset.m_y, m_positionScale.m_y);
+        p.m_position[2] = quantize(v.m_position.m_z, m_positionOffset.m_z, m_positionScale.m_z);
+        p.m_position[3] = 0;
+        encodeOctahedral(v.m_normal, p.m_normal);
+        p.m_uv[0] = toHalf(v.m_uv.m_x);
+        p.m_uv[1] = toHalf(v.m_uv.m_y);
+
+        // Error against what the shader will reconstruct
+        LibMath::Vector3 position(
+            dequantize(p.m_position[0], m_positionOffset.m_x, m_positionScale.m_x),
+            dequantize(p.m_position[1], m_positionOffset.m_y, m_positionScale.m_y),
+            dequantize(p.m_position[2], m_positionOffset.m_z, m_positionScale.m_z));
+        report.m_positionError = std::max(report.m_positionError, (position - v.m_position).magnitude());
+
+        const float normalLength = v.m_normal.magnitude();
+        if (normalLength > 0.0f) {
+            float cosine = decodeOctahedral(p.m_normal).dot(v.m_normal) / normalLength;
+            float degrees = std::acos(std::clamp(cosine, -1.0f, 1.0f)) * 57.2957795f;
+            report.m_normalErrorDegrees = std::max(report.m_normalErrorDegrees, degrees);
+        }
+
+        report.m_uvError = std::max(report.m_uvError, std::max(
+            std::fabs(fromHalf(p.m_uv[0]) - v.m_uv.m_x), std::fabs(fromHalf(p.m_uv[1]) - v.m_uv.m_y)));
+    }
+    report.m_floatBytes  = m_vertexView.size_bytes();
+    report.m_packedBytes = m_packedVertices.size() * sizeof(PackedVertex);
+    m_compressionReport = report;
+
+    if (s_verbose)
+        std::cout << "Model " << m_sourcePath << ": " << m_vertexView.size() << " vertices, "
+            << report.m_floatBytes << " -> " << report.m_packedBytes << " bytes, max error position "
+            << report.m_positionError << ", normal " << report.m_normalErrorDegrees << " deg, uv " << report.m_uvError << "\n";
+}
+
+// --- LODs ---
+namespace {
+    constexpr float k_lodTriangleRatio = 0.5f;  // Each LOD aims for half the triangles of the previous one
+    constexpr float k_lodMinReduction  = 0.8f;  // Stop once a level keeps more than this of the previous one
+    constexpr float k_lodMaxError      = 0.1f;  // Largest simplification error, relative to the bounding radius
+}
+
+void Model::buildLods() {
+    const uint32_t fullCount = uint32_t(m_indices.size());
+    m_lods[0] = { 0, fullCount, 0.0f };
+    m_lodCount = 1;
+
+    const float maxError = m_boundingSphere.getRadius() * k_lodMaxError;
+    std::vector<uint32_t> lodIndices, clusters;
+    uint32_t previousCount = fullCount;
+    while (m_lodCount < k_maxLods) {
+        const size_t target = size_t(float(previousCount / 3) * k_lodTriangleRatio);
+        const float error = MeshOptimizer::simplify(
+            std::span<const Vertex>(m_vertices), std::span<const uint32_t>(m_indices.data(), fullCount), target, maxError, lodIndices);
+        if (lodIndices.empty() || float(lodIndices.size()) > float(previousCount) * k_lodMinReduction)
+            break;
+
+        clusters.clear();
+        MeshOptimizer::optimizeVertexCache(lodIndices, m_vertices.size(), clusters);
+        m_lods[m_lodCount++] = { uint32_t(m_indices.size()), uint32_t(lodIndices.size()), error };
+        m_indices.insert(m_indices.end(), lodIndices.begin(), lodIndices.end());
+        previousCount = uint32_t(lodIndices.size());
+    }
+    m_indexView = m_indices;
+
+    if (s_verbose) {
+        std::cout << "Model " << m_sourcePath << ": LODs";
+        for (size_t i = 0; i < m_lodCount; ++i)
+            std::cout << " " << m_lods[i].m_indexCount / 3 << (i == 0 ? "" : " (error " + std::to_string(m_lods[i].m_error) + ")");
+        std::cout << "\n";
+    }
+}
+
+// --- Residency ---
+void Model::prepareForUpload() {
+    if (s_vertexFormat == VertexFormat::Compressed)
+        packVertices();
+
+    // Built here, on the loading thread, while the full geometry is still around
+    if (s_residency == Residency::GpuOnly)
+        m_collisionProxy.build(m_proxyKind, m_vertexView, getLodIndices(m_lodCount - 1), m_bounds);
+    else
+        m_collisionProxy.clear();
+}
+
+void Model::releaseGeometry() {
+    const size_t before = m_vertexView.size_bytes() + m_indexView.size_bytes();
+
+    std::vector<Vertex>().swap(m_vertices);
+    std::vector<uint32_t>().swap(m_indices);
+    m_cacheFile.close();
+    m_vertexView = {};
+    m_indexView  = {};
+
+    static const char* const k_kindNames[] = { "no", "bounds", "convex hull", "decimated mesh" };
+    if (s_verbose)
+        std::cout << "Model " << m_sourcePath << ": released " << before << " bytes of geometry, kept a "
+            << m_collisionProxy.getBytes() << "-byte " << k_kindNames[int(m_collisionProxy.getKind())] << " proxy ("
+            << m_collisionProxy.getPositions().size() << " positions)\n";
+}
+
 // --- loadFromOBJ ---
 bool Model::loadFromOBJ(const std::string & filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    m_sourcePath = filename;
+    const std::string cachePath = cachePathFor(filename);
+    if (loadCache(cachePath, filename)) {
+        prepareForUpload();
+        return true;
+    }
+
+    VirtualFile file;
+    if (!VirtualFileSystem::map(filename, file)) {
         std::cerr << "Failed to open OBJ file: " << filename << "\n";
         return false;
     }
+    m_cacheFile.close();
+    m_vertices.clear();
+    m_indices.clear();
+    m_lodCount = 0;
+    if (!parseOBJ(file.view(), m_vertices, m_indices)) {
+        std::cerr << "Failed to parse OBJ file: " << filename << "\n";
+        return false;
+    }
+
+    // Cook once: the cache stores the optimized order, so later loads only map it
+    MeshOptimizer::Report report = MeshOptimizer::optimize(m_vertices, m_indices);
+    if (s_verbose)
+        std::cout << "Model " << filename << ": " << m_indices.size() / 3 << " triangles, ACMR "
+            << report.m_acmrBefore << " -> " << report.m_acmrAfter << " (" << MeshOptimizer::k_cacheSize << "-entry cache, "
+            << report.m_clusterCount << " overdraw clusters), " << (m_vertices.size() <= k_maxShortIndexVertices ? 16 : 32) << "-bit indices\n";
+
+    m_vertexView = m_vertices;
+    m_indexView  = m_indices;
+    computeBounds();
+    buildLods();
+
+    // A missing cache only costs the next startup a parse
+    writeCache(cachePath, filename, file.view());
+
+    prepareForUpload();
+    return true;
+}
+
+bool Model::parseOBJ(
+    std::string_view text,
+    std::vector<Vertex>&outVertices,
+    std::vector<uint32_t>&outIndices
+) {
+    // Count the lines of each kind first, so every array is allocated once
+    size_t positionCount = 0, uvCount = 0, normalCount = 0, faceCount = 0;
+    for (size_t pos = 0; pos < text.size(); ) {
+        if (text[pos] == 'f' && pos + 1 < text.size() && text[pos + 1] == ' ')
+            ++faceCount;
+        else if (text[pos] == 'v' && pos + 1 < text.size()) {
+            char next = text[pos + 1];
+            if (next == ' ')      ++positionCount;
+            else if (next == 't') ++uvCount;
+            else if (next == 'n') ++normalCount;
+        }
+        size_t end = text.find('\n', pos);
+        pos = end == std::string_view::npos ? text.size() : end + 1;
+    }
+
     std::vector<LibMath::Vector3> tempPositions;
     std::vector<LibMath::Vector2> tempUVs;
     std::vector<LibMath::Vector3> tempNormals;
-    std::unordered_map<std::string, uint32_t> vertexMap;
+    tempPositions.reserve(positionCount);
+    tempUVs.reserve(uvCount);
+    tempNormals.reserve(normalCount);
+
+    // Closed meshes have about as many unique corners as their largest attribute array;
+    // a face adds at least three corners, which bounds the estimate for soups
+    size_t expectedVertices = std::min(faceCount * 3, std::max({ positionCount, uvCount, normalCount }));
+    outVertices.reserve(outVertices.size() + expectedVertices);
+    outIndices.reserve(outIndices.size() + faceCount * 3);
+    VertexKeyMap vertexMap(expectedVertices);
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
+    TextTokenizer tok(text);
+    while (tok.nextLine()) {
+        std::string_view prefix = tok.next();
         if (prefix == "v") {
-            parseVertexPosition(line, tempPositions);
+            LibMath::Vector3 v;
+            if (!tok.next(v.m_x) || !tok.next(v.m_y) || !tok.next(v.m_z)) {
+                std::cerr << "OBJ: bad vertex at line " << tok.lineNumber() << "\n";
+                return false;
+            }
+            tempPositions.push_back(v);
         }
         else if (prefix == "vt") {
-            parseVertexUV(line, tempUVs);
+            LibMath::Vector2 uv;
+            if (!tok.next(uv.m_x) || !tok.next(uv.m_y)) {
+                std::cerr << "OBJ: bad UV at line " << tok.lineNumber() << "\n";
+                return false;
+            }
+            tempUVs.push_back(uv);
         }
         else if (prefix == "vn") {
-            parseVertexNormal(line, tempNormals);
+            LibMath::Vector3 n;
+            if (!tok.next(n.m_x) || !tok.next(n.m_y) || !tok.next(n.m_z)) {
+                std::cerr << "OBJ: bad normal at line " << tok.lineNumber() << "\n";
+                return false;
+            }
+            tempNormals.push_back(n);
         }
         else if (prefix == "f") {
-            parseFace(line,
-                tempPositions, tempUVs, tempNormals,
-                vertexMap, m_vertices, m_indices);
+            // fan-triangulate: (0, i, i + 1)
+            uint32_t first = 0, previous = 0, current = 0;
+            int count = 0;
+            for (std::string_view token = tok.next(); !token.empty(); token = tok.next(), ++count) {
+                if (!parseFaceVertex(token, tempPositions, tempUVs, tempNormals, vertexMap, outVertices, current)) {
+                    std::cerr << "OBJ: bad face vertex '" << token << "' at line " << tok.lineNumber() << "\n";
+                    return false;
+                }
+                if (count == 0) {
+                    first = current;
+                }
+                else if (count >= 2) {
+                    outIndices.push_back(first);
+                    outIndices.push_back(previous);
+                    outIndices.push_back(current);
+                }
+                previous = current;
+            }
         }
     }
     return true;
 }
 
 // --- parsing helpers ---
-void Model::parseVertexPosition(
-    const std::string & line,
-    std::vector<LibMath::Vector3>&outPositions
-) {
-    std::istringstream iss(line);
-    std::string tag;
-    LibMath::Vector3 v;
-    iss >> tag >> v.m_x >> v.m_y >> v.m_z;
-    outPositions.push_back(v);
+Model::VertexKeyMap::VertexKeyMap(size_t expectedCount) {
+    // Keep the load factor under 1/2
+    size_t capacity = 16;
+    while (capacity < expectedCount * 2)
+        capacity *= 2;
+    m_slots.assign(capacity, Slot{ 0, 0, 0, k_empty });
 }
 
-void Model::parseVertexUV(
-    const std::string & line,
-    std::vector<LibMath::Vector2>&outUVs
-) {
-    std::istringstream iss(line);
-    std::string tag;
-    LibMath::Vector2 uv;
-    iss >> tag >> uv.m_x >> uv.m_y;
-    outUVs.push_back(uv);
+static inline size_t hashTriple(uint32_t v, uint32_t vt, uint32_t vn) {
+    uint64_t h = (uint64_t(v) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(vt) * 0xC2B2AE3D27D4EB4Full) ^ (uint64_t(vn) * 0x165667B19E3779F9ull);
+    h ^= h >> 29;
+    return size_t(h);
 }
 
-void Model::parseVertexNormal(
-    const std::string & line,
-    std::vector<LibMath::Vector3>&outNormals
-) {
-    std::istringstream iss(line);
-    std::string tag;
-    LibMath::Vector3 n;
-    iss >> tag >> n.m_x >> n.m_y >> n.m_z;
-    outNormals.push_back(n);
-}
+uint32_t Model::VertexKeyMap::findOrInsert(uint32_t v, uint32_t vt, uint32_t vn, uint32_t newIndex, bool& outInserted) {
+    if ((m_count + 1) * 2 > m_slots.size())
+        grow();
 
-void Model::parseFaceVertex(
-    const std::string & token,
-    const std::vector<LibMath::Vector3>&tempPositions,
-    const std::vector<LibMath::Vector2>&tempUVs,
-    const std::vector<LibMath::Vector3>&tempNormals,
-    std::unordered_map<std::string, uint32_t>&vertexMap,
-    std::vector<Vertex>&outVertices,
-    std::vector<uint32_t>&outIndices
-) {
-    auto it = vertexMap.find(token);
-    if (it != vertexMap.end()) {
-        outIndices.push_back(it->second);
-        return;
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = hashTriple(v, vt, vn) & mask; ; i = (i + 1) & mask) {
+        Slot& slot = m_slots[i];
+        if (slot.m_index == k_empty) {
+            slot = Slot{ v, vt, vn, newIndex };
+            ++m_count;
+            outInserted = true;
+            return newIndex;
+        }
+        if (slot.m_v == v && slot.m_vt == vt && slot.m_vn == vn) {
+            outInserted = false;
+            return slot.m_index;
+        }
     }
+}
 
-    std::istringstream vss(token);
-    std::string vi_s, ti_s, ni_s;
-    std::getline(vss, vi_s, '/');
-    std::getline(vss, ti_s, '/');
-    std::getline(vss, ni_s, '/');
-
-    int vi = vi_s.empty() ? 0 : std::stoi(vi_s);
-    int ti = ti_s.empty() ? 0 : std::stoi(ti_s);
-    int ni = ni_s.empty() ? 0 : std::stoi(ni_s);
-
-    // convert 1-based or negative
-    if (vi < 0) vi = int(tempPositions.size()) + vi;
-    else         vi -= 1;
-    if (ti < 0) ti = int(tempUVs.size()) + ti;
-    else         ti -= 1;
-    if (ni < 0) ni = int(tempNormals.size()) + ni;
-    else         ni -= 1;
+void Model::VertexKeyMap::grow() {
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    m_slots.assign(old.size() * 2, Slot{ 0, 0, 0, k_empty });
 
-    Vertex vert{};
-    if (vi >= 0 && vi < int(tempPositions.size()))
-        vert.m_position = tempPositions[vi];
-    if (ti >= 0 && ti < int(tempUVs.size()))
-        vert.m_uv = tempUVs[ti];
-    if (ni >= 0 && ni < int(tempNormals.size()))
-        vert.m_normal = tempNormals[ni];
-
-    uint32_t newIndex = uint32_t(outVertices.size());
-    outVertices.push_back(vert);
-    outIndices.push_back(newIndex);
-    vertexMap[token] = newIndex;
+    size_t mask = m_slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.m_index == k_empty)
+            continue;
+        size_t i = hashTriple(slot.m_v, slot.m_vt, slot.m_vn) & mask;
+        while (m_slots[i].m_index != k_empty)
+            i = (i + 1) & mask;
+        m_slots[i] = slot;
+    }
 }
 
-void Model::parseFace(
-    const std::string & line,
+bool Model::parseFaceVertex(
+    std::string_view token,
     const std::vector<LibMath::Vector3>&tempPositions,
     const std::vector<LibMath::Vector2>&tempUVs,
     const std::vector<LibMath::Vector3>&tempNormals,
-    std::unordered_map<std::string, uint32_t>&vertexMap,
+    VertexKeyMap&vertexMap,
     std::vector<Vertex>&outVertices,
-    std::vector<uint32_t>&outIndices
+    uint32_t& outIndex
 ) {
-    std::istringstream iss(line);
-    std::string tag;
-    iss >> tag; // skip "f"
+    // "v", "v/vt", "v//vn" or "v/vt/vn"; a missing index stays 0
+    int indices[3] = { 0, 0, 0 };
+    std::string_view rest = token;
+    for (int k = 0; k < 3 && !rest.empty(); ++k) {
+        size_t slash = rest.find('/');
+        std::string_view part = rest.substr(0, slash);
+        if (!part.empty() && !TextTokenizer::parse(part, indices[k]))
+            return false;
+        rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+    }
 
-    std::vector<std::string> tokens;
-    std::string tok;
-    while (iss >> tok)
-        tokens.push_back(tok);
+    // Resolve 1-based or negative (relative) indices to 1-based absolute ones; 0 = missing or out of range
+    auto resolve = [](int index, size_t count) -> uint32_t {
+        long long absolute = index < 0 ? (long long)count + index + 1 : index;
+        return absolute >= 1 && absolute <= (long long)count ? uint32_t(absolute) : 0u;
+    };
+    uint32_t vi = resolve(indices[0], tempPositions.size());
+    uint32_t ti = resolve(indices[1], tempUVs.size());
+    uint32_t ni = resolve(indices[2], tempNormals.size());
 
-    if (tokens.size() < 3) return;
+    bool inserted = false;
+    outIndex = vertexMap.findOrInsert(vi, ti, ni, uint32_t(outVertices.size()), inserted);
+    if (!inserted)
+        return true;
 
-    // fan-triangulate
-    for (size_t i = 1; i + 1 < tokens.size(); ++i) {
-        parseFaceVertex(tokens[0], tempPositions, tempUVs, tempNormals, vertexMap, outVertices, outIndices);
-        parseFaceVertex(tokens[i], tempPositions, tempUVs, tempNormals, vertexMap, outVertices, outIndices);
-        parseFaceVertex(tokens[i + 1], tempPositions, tempUVs, tempNormals, vertexMap, outVertices, outIndices);
-    }
-}
\ No newline at end of file
+    Vertex vert{};
+    if (vi) vert.m_position = tempPositions[vi - 1];
+    if (ti) vert.m_uv       = tempUVs[ti - 1];
+    if (ni) vert.m_normal   = tempNormals[ni - 1];
+    outVertices.push_back(vert);
+    return true;
+}
@@ -0,0 +1,319 @@
+#include "PakArchive.h"
+#include "SourceStamp.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+    struct PakHeader {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_entryCount;
+        uint32_t m_nameBytes;
+        uint64_t m_archiveSize;     // Whole file, catches truncated copies
+        uint64_t m_padding;
+    };
+    static_assert(sizeof(PakHeader) % 16 == 0 && sizeof(PakArchive::Entry) % 16 == 0, "The index must stay aligned");
+
+    // LZ4 block layout: sequences of [token][literal length+][literals][offset:2][match length+].
+    // The token holds the literal length (high nibble) and match length - k_minMatch (low nibble), 15 meaning
+    // "more bytes follow", each adding up to 255. The last sequence only has literals.
+    constexpr size_t   k_minMatch  = 4;
+    constexpr size_t   k_maxOffset = 0xFFFF;
+    constexpr uint32_t k_hashBits  = 14;
+
+    uint32_t read32(const char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void putLength(std::vector<char>& out, size_t length) {
+        for (; length >= 255; length -= 255)
+            out.push_back(char(255));
+        out.push_back(char(length));
+    }
+
+    void putSequence(std::vector<char>& out, std::string_view literals, size_t offset, size_t matchLength) {
+        const size_t literalCount = literals.size();
+        const size_t matchCode = matchLength ? matchLength - k_minMatch : 0;
+        out.push_back(char((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalCount >= 15)
+            putLength(out, literalCount - 15);
+        out.insert(out.end(), literals.begin(), literals.end());
+        if (!matchLength)
+            return;
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if (matchCode >= 15)
+            putLength(out, matchCode - 15);
+    }
+
+    bool getLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+        unsigned char byte;
+        do {
+            if (in == end)
+                return false;
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    size_t alignUp(size_t value) {
+        return (value + PakArchive::k_alignment - 1) & ~(PakArchive::k_alignment - 1);
+    }
+}
+
+uint64_t PakArchive::hashName(std::string_view name) {
+    return SourceStamp::hash(name);
+}
+
+void PakArchive::compress(std::string_view bytes, std::vector<char>& out) {
+    out.clear();
+    out.reserve(bytes.size() + bytes.size() / 255 + 16);
+
+    // Last position of each hashed 4-byte sequence, one candidate per bucket (greedy, like LZ4's fast mode)
+    std::vector<uint32_t> table(size_t(1) << k_hashBits, UINT32_MAX);
+    const char* data = bytes.data();
+    const size_t size = bytes.size();
+    size_t anchor = 0, pos = 0;
+    while (pos + k_minMatch <= size) {
+        const uint32_t sequence = read32(data + pos);
+        const uint32_t slot = (sequence * 2654435761u) >> (32 - k_hashBits);
+        const size_t candidate = table[slot];
+        table[slot] = uint32_t(pos);
+        if (candidate == UINT32_MAX || pos - candidate > k_maxOffset || read32(data + candidate) != sequence) {
+            ++pos;
+            continue;
+        }
+
+        size_t length = k_minMatch;
+        while (pos + length < size && data[candidate + length] == data[pos + length])
+            ++length;
+        putSequence(out, bytes.substr(anchor, pos - anchor), pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    putSequence(out, bytes.substr(anchor), 0, 0);
+}
+
+bool PakArchive::decompress(std::string_view compressed, char* out, size_t size) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(compressed.data());
+    const unsigned char* end = in + compressed.size();
+    size_t written = 0;
+    while (in < end) {
+        const unsigned char token = *in++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !getLength(in, end, literalCount))
+            return false;
+        if (literalCount > size_t(end - in) || literalCount > size - written)
+            return false;
+        std::memcpy(out + written, in, literalCount);
+        in += literalCount;
+        written += literalCount;
+        if (in == end)
+            break;
+
+        if (end - in < 2)
+            return false;
+        const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(in, end, matchLength))
+            return false;
+        matchLength += k_minMatch;
+        if (offset == 0 || offset > written || matchLength > size - written)
+            return false;
+
+        // Byte by byte: the match may overlap the bytes it is producing (runs)
+        const char* from = out + written - offset;
+        for (size_t i = 0; i < matchLength; ++i)
+            out[written + i] = from[i];
+        written += matchLength;
+    }
+    return written == size;
+}
+
+bool PakArchive::open(const std::string& path) {
+    close();
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    PakHeader header{};
+    if (file.size() >= sizeof(header))
+        std::memcpy(&header, file.data(), sizeof(header));
+    const size_t indexEnd = sizeof(PakHeader) + size_t(header.m_entryCount) * sizeof(Entry);
+    if (header.m_magic != k_magic || header.m_version != k_version || header.m_archiveSize != file.size() ||
+        indexEnd > file.size() || file.size() - indexEnd < header.m_nameBytes) {
+        std::cerr << "PakArchive: " << path << " is not a valid archive (version " << k_version << ")\n";
+        return false;
+    }
+
+    // The mapping is page aligned and the header keeps the index 16-byte aligned: it is used in place
+    std::span<const Entry> entries(reinterpret_cast<const Entry*>(file.data() + sizeof(PakHeader)), header.m_entryCount);
+    std::string_view names(file.data() + indexEnd, header.m_nameBytes);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        const bool sorted = i == 0 || entries[i - 1].m_hash <= entry.m_hash;
+        const bool sizes = (entry.m_flags & Compressed) || entry.m_storedSize == entry.m_size;
+        if (!sorted || !sizes || size_t(entry.m_nameOffset) + entry.m_nameLength > names.size() ||
+            entry.m_offset % k_alignment != 0 || entry.m_offset > file.size() || file.size() - entry.m_offset < entry.m_storedSize) {
+            std::cerr << "PakArchive: " << path << " has a corrupt index\n";
+            return false;
+        }
+    }
+
+    m_file = std::move(file);
+    m_entries = entries;
+    m_names = names;
+    return true;
+}
+
+void PakArchive::close() {
+    m_entries = {};
+    m_names = {};
+    m_file.close();
+}
+
+const PakArchive::Entry* PakArchive::find(std::string_view name) const {
+    const uint64_t hash = hashName(name);
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+        [](const Entry& entry, uint64_t value) { return entry.m_hash < value; });
+    for (; it != m_entries.end() && it->m_hash == hash; ++it)
+        if (getName(*it) == name)
+            return &*it;
+    return nullptr;
+}
+
+std::string_view PakArchive::getName(const Entry& entry) const {
+    return m_names.substr(entry.m_nameOffset, entry.m_nameLength);
+}
+
+std::string_view PakArchive::getStored(const Entry& entry) const {
+    return { m_file.data() + entry.m_offset, size_t(entry.m_storedSize) };
+}
+
+bool PakArchive::inflate(const Entry& entry, char* out) const {
+    if (!(entry.m_flags & Compressed)) {
+        std::memcpy(out, m_file.data() + entry.m_offset, size_t(entry.m_size));
+        return true;
+    }
+    if (!decompress(getStored(entry), out, size_t(entry.m_size))) {
+        std::cerr << "PakArchive: corrupt data for " << getName(entry) << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PakArchive::write(const std::string& path, std::span<const Source> sources, WriteStats* outStats) {
+    // Index order: by hash, then by name so equal hashes stay deterministic
+    std::vector<const Source*> order;
+    order.reserve(sources.size());
+    for (const Source& source : sources)
+        order.push_back(&source);
+    std::vector<uint64_t> hashes(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+        hashes[i] = hashName(sources[i].m_name);
+    auto hashOf = [&](const Source* source) { return hashes[size_t(source - sources.data())]; };
+    std::sort(order.begin(), order.end(), [&](const Source* l, const Source* r) {
+        return hashOf(l) != hashOf(r) ? hashOf(l) < hashOf(r) : l->m_name < r->m_name;
+    });
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (order[i - 1]->m_name == order[i]->m_name) {
+            std::cerr << "PakArchive: " << order[i]->m_name << " is packed twice\n";
+            return false;
+        }
+    }
+
+    // Compress on every core, each entry on its own
+    std::vector<std::vector<char>> compressed(order.size());
+    {
+        const size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threadCount; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i = t; i < order.size(); i += threadCount) {
+                    if (!order[i]->m_compress)
+                        continue;
+                    compress(order[i]->m_bytes, compressed[i]);
+                    if (compressed[i].size() > order[i]->m_bytes.size() - order[i]->m_bytes.size() / k_minSaving)
+                        std::vector<char>().swap(compressed[i]);
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    std::vector<Entry> entries(order.size());
+    std::string names;
+    WriteStats stats;
+    stats.m_entryCount = order.size();
+    for (size_t i = 0; i < order.size(); ++i) {
+        Entry& entry = entries[i];
+        entry = {};
+        entry.m_hash = hashOf(order[i]);
+        entry.m_nameOffset = uint32_t(names.size());
+        entry.m_nameLength = uint32_t(order[i]->m_name.size());
+        entry.m_size = order[i]->m_bytes.size();
+        entry.m_storedSize = compressed[i].empty() ? entry.m_size : compressed[i].size();
+        entry.m_flags = compressed[i].empty() ? 0 : uint32_t(Compressed);
+        names += order[i]->m_name;
+        stats.m_sourceBytes += entry.m_size;
+        stats.m_compressedCount += compressed[i].empty() ? 0 : 1;
+    }
+
+    size_t offset = alignUp(sizeof(PakHeader) + entries.size() * sizeof(Entry) + names.size());
+    for (Entry& entry : entries) {
+        entry.m_offset = offset;
+        offset = alignUp(offset + size_t(entry.m_storedSize));
+    }
+
+    PakHeader header{};
+    header.m_magic = k_magic;
+    header.m_version = k_version;
+    header.m_entryCount = uint32_t(entries.size());
+    header.m_nameBytes = uint32_t(names.size());
+    header.m_archiveSize = entries.empty() ? sizeof(PakHeader) + names.size() : entries.back().m_offset + entries.back().m_storedSize;
+    stats.m_archiveBytes = header.m_archiveSize;
+
+    // Write to a temporary file first, a crash mid-write must not leave a valid-looking archive
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        const char zeros[k_alignment] = {};
+        auto padTo = [&](uint64_t position) {
+            out.write(zeros, std::streamsize(position - uint64_t(out.tellp())));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size() * sizeof(Entry)));
+        out.write(names.data(), std::streamsize(names.size()));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            padTo(entries[i].m_offset);
+            if (compressed[i].empty())
+                out.write(order[i]->m_bytes.data(), std::streamsize(order[i]->m_bytes.size()));
+            else
+                out.write(compressed[i].data(), std::streamsize(compressed[i].size()));
+        }
+        if (!out) {
+            std::cerr << "PakArchive: cannot write " << path << "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        std::cerr << "PakArchive: cannot write " << path << "\n";
+        return false;
+    }
+
+    if (outStats)
+        *outStats = stats;
+    return true;
+}
@@ -1,21 +1,168 @@
 #include"ResourceManager.h"
+#include"Texture.h"
+#include"VirtualFileSystem.h"
+#include"SourceStamp.h"
+#include<filesystem>
+#include<algorithm>
 #include<iostream>
 
 ResourceManager::~ResourceManager() 
 {
-    for (auto& pair : resources) 
+    // Each pool deletes its own resources
+    pools.clear();
+    textureContents.clear();
+}
+// Intern a name
+NameId ResourceManager::intern(std::string_view name)
+{
+    auto it = nameIds.find(name);
+    if (it != nameIds.end())
     {
-        delete pair.second;
+        return it->second;
     }
-    resources.clear();
+
+    NameId id = NameId(names.size());
+    names.emplace_back(name);
+    nameIds.emplace(names.back(), id);
+    return id;
+}
+// Look up a name without interning it
+NameId ResourceManager::findName(std::string_view name) const
+{
+    auto it = nameIds.find(name);
+    return it != nameIds.end() ? it->second : k_invalidName;
 }
 // Delete a resource by name
 void ResourceManager::delete_resource(const std::string& name) 
 {
-    auto it = resources.find(name);
-    if (it != resources.end()) 
+    NameId id = findName(name);
+    if (id == k_invalidName)
+    {
+        return;
+    }
+    for (auto& storage : pools)
+    {
+        if (!storage)
+        {
+            continue;
+        }
+        if (IResource* resource = storage->detach(id))
+        {
+            forget(resource);
+            storage->collect();
+        }
+    }
+}
+// Forget the content entry of a texture being unregistered
+void ResourceManager::forget(IResource* resource)
+{
+    for (auto it = textureContents.begin(); it != textureContents.end(); ++it)
+    {
+        if (it->second == resource)
+        {
+            textureContents.erase(it);
+            break;
+        }
+    }
+}
+// Collect released resources and evict down to the budget
+void ResourceManager::update()
+{
+    for (auto& storage : pools)
+    {
+        if (storage)
+        {
+            storage->collect();
+        }
+    }
+
+    if (memoryBudget == 0)
+    {
+        return;
+    }
+    MemoryStats total = getMemoryStats();
+    if (total.totalBytes() <= memoryBudget)
+    {
+        return;
+    }
+
+    // Least recently used first
+    std::vector<IResource*> candidates;
+    for (auto& storage : pools)
+    {
+        if (storage)
+        {
+            storage->gatherEvictable(candidates);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const IResource* a, const IResource* b)
+    {
+        return a->getLastUse() < b->getLastUse();
+    });
+
+    size_t used = total.totalBytes();
+    for (IResource* resource : candidates)
+    {
+        if (used <= memoryBudget)
+        {
+            break;
+        }
+        size_t bytes = resource->getCpuBytes() + resource->getGpuBytes();
+        if (bytes > 0 && resource->evict())
+        {
+            resource->m_evicted = true;
+            used -= std::min(used, bytes);
+            ++evictionCount;
+        }
+    }
+}
+// Memory held by every resource
+ResourceManager::MemoryStats ResourceManager::getMemoryStats() const
+{
+    MemoryStats stats;
+    for (const auto& storage : pools)
+    {
+        if (storage)
+        {
+            storage->addStats(stats);
+        }
+    }
+    return stats;
+}
+// Find or create the texture of an image file
+Texture* ResourceManager::acquireTexture(const std::string& path, bool& outIsNew)
+{
+    outIsNew = false;
+
+    // Same file, however the path was spelled
+    std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+    if (Texture* texture = get(find<Texture>(std::string_view(key))))
+    {
+        return texture;
+    }
+
+    // Same bytes under another name (the hash is cheap next to a decode and a GPU copy)
+    ContentKey content;
+    VirtualFile file;
+    bool hashed = VirtualFileSystem::exists(path) && VirtualFileSystem::map(path, file);
+    if (hashed)
+    {
+        content.m_size = file.size();
+        content.m_hash = SourceStamp::hash(file.view());
+        auto it = textureContents.find(content);
+        if (it != textureContents.end())
+        {
+            // Not registered under this path: every resource has a single owning slot
+            return it->second;
+        }
+    }
+
+    // A file that cannot be read still gets its texture, the load reports the error
+    Texture* texture = create<Texture>(key);
+    if (hashed)
     {
-        delete it->second;
-        resources.erase(it);
+        textureContents[content] = texture;
     }
+    outIsNew = true;
+    return texture;
 }
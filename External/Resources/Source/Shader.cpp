@@ -1,43 +1,95 @@
 ﻿#include "Shader.h"
+#include "GLExtensions.h"
+#include "MappedFile.h"
+#include "VirtualFileSystem.h"
+#include "SourceStamp.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t k_sprogMagic   = 0x47525053; // "SPRG"
+    constexpr uint32_t k_sprogVersion = 1;
+
+    // File layout: header, then m_length bytes of driver binary
+    struct SProgHeader
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint64_t m_key;
+        uint32_t m_format;
+        uint32_t m_length;
+    };
+
+    const char* glString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+}
 
 Shader::Shader() 
 {
     m_programID = glCreateProgram();
-    std::cout << "Created program ID=" << m_programID << "\n";
 }
 
 Shader::~Shader() 
 {
-    for (auto shader : m_attachedShaders) 
-    {
-        glDeleteShader(shader);
-    }
     glDeleteProgram(m_programID);
 }
 
 // Load a file into a string
 std::string Shader::loadFile(const std::string& filepath) 
 {
-    std::ifstream file(filepath);
+    std::unique_ptr<std::istream> file = VirtualFileSystem::open(filepath);
     if (!file) return "";
     std::stringstream buffer;
-    buffer << file.rdbuf();
+    buffer << file->rdbuf();
     return buffer.str();
 }
 
-// Compile a shader from source code
+// Insert the defines after the #version line (which must stay first)
+std::string Shader::withDefines(const std::string& source) const
+{
+    if (m_defines.empty())
+    {
+        return source;
+    }
+
+    std::string defines;
+    for (const auto& [name, value] : m_defines)
+    {
+        defines += "#define " + name + " " + value + "\n";
+    }
+
+    size_t insertAt = 0;
+    size_t version = source.find("#version");
+    if (version != std::string::npos)
+    {
+        size_t lineEnd = source.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    }
+    std::string result = source.substr(0, insertAt);
+    if (!result.empty() && result.back() != '\n')
+    {
+        result += '\n';
+    }
+    return result + defines + source.substr(insertAt);
+}
+
+// Compile a shader from source code and attach it
 bool Shader::compileShader(const std::string& source, GLenum shaderType, GLuint& shaderID) 
 {
-	// Check if shader type is valid
     const char* src = source.c_str();
     shaderID = glCreateShader(shaderType);
-    std::cout << "[Shader] glCreateShader → shaderID=" << shaderID << "\n";
-
     glShaderSource(shaderID, 1, &src, nullptr);
     glCompileShader(shaderID);
+
 	// Check for compile errors
     GLint status = GL_FALSE;
     glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
@@ -45,21 +97,12 @@ bool Shader::compileShader(const std::string& source, GLenum shaderType, GLuint&
         char buf[512];
         glGetShaderInfoLog(shaderID, 512, nullptr, buf);
         std::cerr << "Compile error:\n" << buf << "\n";
+        glDeleteShader(shaderID);
+        shaderID = 0;
         return false;
     }
 
-    // Attach
     glAttachShader(m_programID, shaderID);
-
-    // **immediately** check how many shaders are attached now
-    {
-        GLint count = 0;
-        glGetProgramiv(m_programID, GL_ATTACHED_SHADERS, &count);
-        std::cout << "[Shader] after attach, ATTACHED_SHADERS=" << count << "\n";
-    }
-
-    m_attachedShaders.push_back(shaderID);
-    std::cout << "[Shader] CompileShader done\n";
     return true;
 }
 
@@ -67,13 +110,9 @@ bool Shader::compileShader(const std::string& source, GLenum shaderType, GLuint&
 bool Shader::setVertexShader(const std::string& filename) 
 {
     std::string source = loadFile(filename);
-    std::cout << "GL version: " << glGetString(GL_VERSION) << "\n";
-    std::cout << "Shader source length: " << source.size() << "\n";
-    std::cout << "First line: " << source.substr(0, source.find('\n')) << "\n";
     if (source.empty()) return false;
-    GLuint id;
-    std::cout << "compiling vertex shader" << std::endl;
-    return compileShader(source, GL_VERTEX_SHADER, id);
+    m_stages.push_back({ GL_VERTEX_SHADER, std::move(source) });
+    return true;
 }
 
 // Set the fragment shader from a file
@@ -81,28 +120,172 @@ bool Shader::setFragmentShader(const std::string& filename)
 {
     std::string source = loadFile(filename);
     if (source.empty()) return false;
-    GLuint id;
-    return compileShader(source, GL_FRAGMENT_SHADER, id);
+    m_stages.push_back({ GL_FRAGMENT_SHADER, std::move(source) });
+    return true;
+}
+
+void Shader::addDefine(const std::string& name, const std::string& value)
+{
+    m_defines.emplace_back(name, value);
+}
+
+// Hash of everything the driver binary depends on
+uint64_t Shader::cacheKey() const
+{
+    std::string key;
+    key += glString(GL_VENDOR);
+    key += '\n';
+    key += glString(GL_RENDERER);
+    key += '\n';
+    key += glString(GL_VERSION);
+    key += '\n';
+    for (const Stage& stage : m_stages)
+    {
+        key += std::to_string(stage.m_type);
+        key += '\n';
+        key += withDefines(stage.m_source);
+    }
+    return SourceStamp::hash(key);
+}
+
+// Try the cached binary; false leaves the program unlinked
+bool Shader::loadBinary(const std::filesystem::path& path, uint64_t key)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+    {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(path.string()) || file.size() < sizeof(SProgHeader))
+    {
+        return false;
+    }
+    SProgHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.m_magic != k_sprogMagic || header.m_version != k_sprogVersion || header.m_key != key ||
+        file.size() != sizeof(SProgHeader) + size_t(header.m_length))
+    {
+        return false;
+    }
+
+    // The driver may still refuse it (updated, different GPU): that is a link failure, not an error
+    GLExtensions::programBinary(m_programID, header.m_format, file.data() + sizeof(SProgHeader), GLsizei(header.m_length));
+    GLint success = 0;
+    glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+    return success == GL_TRUE;
+}
+
+// Store the linked program's binary
+void Shader::saveBinary(const std::filesystem::path& path, uint64_t key) const
+{
+    GLint length = 0;
+    glGetProgramiv(m_programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    SProgHeader header{};
+    header.m_magic   = k_sprogMagic;
+    header.m_version = k_sprogVersion;
+    header.m_key     = key;
+    GLsizei written = 0;
+    GLExtensions::getProgramBinary(m_programID, length, &written, reinterpret_cast<GLenum*>(&header.m_format), binary.data());
+    if (written <= 0)
+    {
+        return;
+    }
+    header.m_length = uint32_t(written);
+
+    // Write to a temporary file first, a crash mid-write must not leave a valid-looking cache
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::string tempPath = path.string() + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), written);
+        if (!out)
+        {
+            std::cerr << "Cannot write shader cache: " << path.string() << "\n";
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        std::cerr << "Cannot write shader cache: " << path.string() << "\n";
+    }
 }
 
-// Set the geometry shader from a file
+// Link the program, from the binary cache when it matches
 bool Shader::link() 
 {
-    // Check again before linking
-    GLint count = 0;
-    glGetProgramiv(m_programID, GL_ATTACHED_SHADERS, &count);
-    std::cout << "[Shader] before link, ATTACHED_SHADERS=" << count
-        << "  programID=" << m_programID << "\n";
-    if (count == 0) 
+    if (m_stages.empty()) 
     {
-        std::cerr << "Shader::Link() error: no attached shader objects\n";
+        std::cerr << "Shader::Link() error: no shader source set\n";
         return false;
     }
 
+    m_fromCache = false;
+    const bool useCache = !s_cacheDirectory.empty() && GLExtensions::hasProgramBinary();
+    uint64_t key = 0;
+    std::filesystem::path cachePath;
+    if (useCache)
+    {
+        key = cacheKey();
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.sprog", static_cast<unsigned long long>(key));
+        cachePath = s_cacheDirectory / name;
+        if (loadBinary(cachePath, key))
+        {
+            m_fromCache = true;
+            reflectUniforms();
+            return true;
+        }
+    }
+
+    // Compile every stage
+    std::vector<GLuint> shaders;
+    bool compiled = true;
+    for (const Stage& stage : m_stages)
+    {
+        GLuint shaderID = 0;
+        if (!compileShader(withDefines(stage.m_source), stage.m_type, shaderID))
+        {
+            compiled = false;
+            break;
+        }
+        shaders.push_back(shaderID);
+    }
+
 	// Link the program
-    glLinkProgram(m_programID);
     GLint success = 0;
-    glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+    if (compiled)
+    {
+        if (useCache)
+        {
+            GLExtensions::programParameteri(m_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glLinkProgram(m_programID);
+        glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+    }
+
+    // The program keeps its own copy of the linked code
+    for (GLuint shaderID : shaders)
+    {
+        glDetachShader(m_programID, shaderID);
+        glDeleteShader(shaderID);
+    }
+
+    if (!compiled)
+    {
+        return false;
+    }
     if (!success) 
     {
         char infoLog[512];
@@ -110,10 +293,114 @@ bool Shader::link()
         std::cerr << "Shader program link failed:\n" << infoLog << std::endl;
         return false;
     }
-    std::cout << "shaders linking success" << std::endl;
+
+    if (useCache)
+    {
+        saveBinary(cachePath, key);
+    }
+    reflectUniforms();
     return true;
 }
 
+// Build the uniform tables of the linked program
+void Shader::reflectUniforms()
+{
+    m_uniforms.clear();
+    m_uniformArrays.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> buffer(static_cast<size_t>(std::max(maxLength, 1)));
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_programID, GLuint(i), GLsizei(buffer.size()), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), size_t(length));
+
+        // Arrays of basic types are reported once, as "name[0]" with their size: list every element
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            for (GLint element = 0; element < size; ++element)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                addUniform(elementName, glGetUniformLocation(m_programID, elementName.c_str()));
+            }
+            m_uniforms[base] = m_uniforms[name];
+            continue;
+        }
+        addUniform(name, glGetUniformLocation(m_programID, name.c_str()));
+    }
+}
+
+// Register a uniform, and under its array pattern if it is an array element ("a[2].b" -> "a[].b")
+void Shader::addUniform(const std::string& name, GLint location)
+{
+    UniformHandle handle{ location };
+    m_uniforms[name] = handle;
+
+    size_t open = name.find('[');
+    size_t close = open == std::string::npos ? std::string::npos : name.find(']', open);
+    if (close == std::string::npos)
+    {
+        return;
+    }
+
+    int index = 0;
+    if (std::from_chars(name.data() + open + 1, name.data() + close, index).ec == std::errc() && index >= 0)
+    {
+        std::string pattern = name.substr(0, open + 1) + name.substr(close);
+        std::vector<UniformHandle>& elements = m_uniformArrays[pattern];
+        if (elements.size() <= size_t(index))
+        {
+            elements.resize(size_t(index) + 1);
+        }
+        elements[size_t(index)] = handle;
+    }
+}
+
+UniformHandle Shader::uniform(std::string_view name) const
+{
+    auto it = m_uniforms.find(name);
+    return it != m_uniforms.end() ? it->second : UniformHandle{};
+}
+
+const std::vector<UniformHandle>& Shader::uniformArray(std::string_view pattern) const
+{
+    static const std::vector<UniformHandle> s_empty;
+    auto it = m_uniformArrays.find(pattern);
+    return it != m_uniformArrays.end() ? it->second : s_empty;
+}
+
+void Shader::set(UniformHandle handle, int value) const
+{
+    if (handle.isValid()) glUniform1i(handle.m_location, value);
+}
+
+void Shader::set(UniformHandle handle, float value) const
+{
+    if (handle.isValid()) glUniform1f(handle.m_location, value);
+}
+
+void Shader::set(UniformHandle handle, const LibMath::Vector3& value) const
+{
+    if (handle.isValid()) glUniform3f(handle.m_location, value.m_x, value.m_y, value.m_z);
+}
+
+void Shader::set(UniformHandle handle, const LibMath::Vector4& value) const
+{
+    if (handle.isValid()) glUniform4f(handle.m_location, value.m_x, value.m_y, value.m_z, value.m_w);
+}
+
+void Shader::set(UniformHandle handle, const LibMath::Matrix4& value) const
+{
+    if (handle.isValid()) glUniformMatrix4fv(handle.m_location, 1, GL_FALSE, value.getData());
+}
+
 // Set the shader program to be used
 void Shader::use() const 
 {
@@ -127,5 +414,5 @@ GLuint Shader::getID() const
 
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
-}
+	set(uniform(name), value);
+}
\ No newline at end of file
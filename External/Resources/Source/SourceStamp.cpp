@@ -0,0 +1,63 @@
+#include "SourceStamp.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    bool sizeAndTime(const std::string& path, uint64_t& outSize, int64_t& outTime) {
+        std::error_code ec;
+        outSize = std::filesystem::file_size(path, ec);
+        if (ec) return false;
+        outTime = int64_t(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        return !ec;
+    }
+}
+
+uint64_t SourceStamp::hash(std::string_view bytes) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool SourceStamp::make(const std::string& path, std::string_view content, SourceStamp& outStamp) {
+    if (!sizeAndTime(path, outStamp.m_size, outStamp.m_time))
+        return false;
+    outStamp.m_hash = hash(content);
+    return true;
+}
+
+bool SourceStamp::matches(const std::string& path, bool* outRetimed) const {
+    uint64_t size = 0;
+    int64_t  time = 0;
+    if (!sizeAndTime(path, size, time))
+        return true;
+    if (size != m_size)
+        return false;
+    if (time == m_time)
+        return true;
+
+    MappedFile source;
+    if (!source.open(path) || hash(source.view()) != m_hash)
+        return false;
+    if (outRetimed)
+        *outRetimed = true;
+    return true;
+}
+
+bool SourceStamp::rewrite(const std::string& sourcePath, const std::string& cachePath, size_t offset) {
+    uint64_t size = 0;
+    int64_t  time = 0;
+    if (!sizeAndTime(sourcePath, size, time) || size != m_size)
+        return false;
+    m_time = time;
+
+    std::fstream cache(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!cache)
+        return false;
+    cache.seekp(std::streamoff(offset));
+    cache.write(reinterpret_cast<const char*>(this), sizeof(*this));
+    return bool(cache);
+}
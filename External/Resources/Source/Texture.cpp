@@ -1,7 +1,258 @@
 #include "Texture.h"
+#include "VirtualFileSystem.h"
+#include "SourceStamp.h"
+#include "GLExtensions.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stdexcept>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <string>
+
+// --- .stex cache ---
+namespace
+{
+	constexpr uint32_t	k_stexMagic = 0x58455453;	// "STEX"
+	constexpr uint32_t	k_stexVersion = 2;
+	constexpr int		k_maxLevels = 16;
+	constexpr int		k_solidTolerance = 2;	// Per channel, absorbs JPEG noise on single-colour images
+
+	// File layout: header, then every level's rows back to back (bottom-up, tightly packed)
+	struct STexHeader
+	{
+		uint32_t	m_magic;
+		uint32_t	m_version;
+		uint32_t	m_width;
+		uint32_t	m_height;
+		uint32_t	m_channels;
+		uint32_t	m_levelCount;
+		SourceStamp	m_source;					// Image the cache was built from
+		uint64_t	m_offsets[k_maxLevels];		// From the start of the file
+		uint64_t	m_sizes[k_maxLevels];
+	};
+	static_assert(sizeof(STexHeader) % 16 == 0, "STexHeader must keep the level data aligned");
+
+	// sRGB transfer tables: 8-bit sRGB to linear, and 16-bit linear back to 8-bit sRGB
+	struct SRGBTables
+	{
+		float		m_toLinear[256];
+		uint8_t		m_toSRGB[65536];
+	};
+
+	const SRGBTables& srgbTables()
+	{
+		static const SRGBTables* tables = []
+		{
+			SRGBTables* result = new SRGBTables;
+			for (int i = 0; i < 256; ++i)
+			{
+				float c = float(i) / 255.0f;
+				result->m_toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < 65536; ++i)
+			{
+				float l = float(i) / 65535.0f;
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				result->m_toSRGB[i] = uint8_t(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+			return result;
+		}();
+		return *tables;
+	}
+
+	bool isSolid(const unsigned char* pixels, int width, int height, int channels)
+	{
+		const size_t size = size_t(width) * size_t(height) * size_t(channels);
+		for (size_t i = size_t(channels); i < size; ++i)
+		{
+			if (std::abs(int(pixels[i]) - int(pixels[i % channels])) > k_solidTolerance)
+				return false;
+		}
+		return true;
+	}
+
+	int levelCountFor(int width, int height)
+	{
+		int levels = 1;
+		for (int size = std::max(width, height); size > 1 && levels < k_maxLevels; size /= 2)
+			++levels;
+		return levels;
+	}
+
+	// Halve one level with a 2x2 box filter, clamping at odd edges.
+	// Colour channels of RGB(A) images are averaged in linear space; alpha and 1-2 channel images
+	// (masks, data) are averaged as stored. The loops are kept branch-free so the compiler vectorizes them.
+	void downsample(const unsigned char* src, int width, int height, int channels, unsigned char* dst)
+	{
+		const SRGBTables& tables = srgbTables();
+		const bool srgb = channels >= 3;
+		const int dstWidth = std::max(1, width / 2);
+		const int dstHeight = std::max(1, height / 2);
+		const size_t rowSize = size_t(width) * size_t(channels);
+
+		std::vector<float> sum(rowSize);
+		std::vector<float> dstRow(size_t(dstWidth) * size_t(channels));
+
+		auto accumulate = [&](const unsigned char* row, bool first)
+		{
+			float* out = sum.data();
+			if (srgb)
+			{
+				for (size_t i = 0; i < rowSize; ++i)
+					out[i] = (first ? 0.0f : out[i]) + tables.m_toLinear[row[i]];
+				if (channels == 4)
+				{
+					for (size_t i = 3; i < rowSize; i += 4)
+						out[i] += float(row[i]) / 255.0f - tables.m_toLinear[row[i]];
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < rowSize; ++i)
+					out[i] = (first ? 0.0f : out[i]) + float(row[i]) / 255.0f;
+			}
+		};
+
+		for (int y = 0; y < dstHeight; ++y)
+		{
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			accumulate(src + size_t(y0) * rowSize, true);
+			accumulate(src + size_t(y1) * rowSize, false);
+
+			for (int x = 0; x < dstWidth; ++x)
+			{
+				const float* a = sum.data() + size_t(std::min(x * 2, width - 1)) * channels;
+				const float* b = sum.data() + size_t(std::min(x * 2 + 1, width - 1)) * channels;
+				for (int c = 0; c < channels; ++c)
+					dstRow[size_t(x) * channels + c] = (a[c] + b[c]) * 0.25f;
+			}
+
+			unsigned char* out = dst + size_t(y) * size_t(dstWidth) * size_t(channels);
+			for (size_t i = 0; i < dstRow.size(); ++i)
+			{
+				float v = std::clamp(dstRow[i], 0.0f, 1.0f);
+				out[i] = srgb ? tables.m_toSRGB[int(v * 65535.0f + 0.5f)] : uint8_t(v * 255.0f + 0.5f);
+			}
+			if (channels == 4)
+			{
+				for (size_t i = 3; i < dstRow.size(); i += 4)
+					out[i] = uint8_t(std::clamp(dstRow[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	bool loadCache(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath, TextureData& outData)
+	{
+		if (!VirtualFileSystem::exists(cachePath.string()))
+			return false;
+
+		auto cache = std::make_shared<VirtualFile>();
+		if (!VirtualFileSystem::map(cachePath.string(), *cache) || cache->size() < sizeof(STexHeader))
+			return false;
+
+		STexHeader header;
+		std::memcpy(&header, cache->data(), sizeof(header));
+		if (header.m_magic != k_stexMagic || header.m_version != k_stexVersion ||
+			header.m_channels < 1 || header.m_channels > 4 || header.m_width == 0 || header.m_height == 0 ||
+			header.m_levelCount != uint32_t(levelCountFor(int(header.m_width), int(header.m_height))))
+			return false;
+
+		bool retimed = false;
+		if (!header.m_source.matches(sourcePath.string(), &retimed))
+			return false;
+		if (retimed && !cache->isPacked())
+		{
+			// Same image under a new time: store the time so the next load skips hashing it (best effort)
+			const size_t size = cache->size();
+			cache->close();
+			header.m_source.rewrite(sourcePath.string(), cachePath.string(), offsetof(STexHeader, m_source));
+			if (!VirtualFileSystem::map(cachePath.string(), *cache) || cache->size() != size)
+				return false;
+		}
+
+		std::vector<TextureData::Level> levels(header.m_levelCount);
+		int width = int(header.m_width), height = int(header.m_height);
+		for (uint32_t i = 0; i < header.m_levelCount; ++i)
+		{
+			size_t size = size_t(width) * size_t(height) * header.m_channels;
+			if (header.m_sizes[i] != size || header.m_offsets[i] > cache->size() || cache->size() - header.m_offsets[i] < size)
+				return false;
+
+			levels[i].m_width = width;
+			levels[i].m_height = height;
+			levels[i].m_pixels = reinterpret_cast<const unsigned char*>(cache->data() + header.m_offsets[i]);
+			levels[i].m_size = size;
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		outData.m_path = sourcePath;
+		outData.m_width = int(header.m_width);
+		outData.m_height = int(header.m_height);
+		outData.m_channels = int(header.m_channels);
+		outData.m_levels = std::move(levels);
+		outData.m_storage = std::move(cache);
+		return true;
+	}
+
+	bool writeCache(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath, std::string_view sourceBytes, const TextureData& data)
+	{
+		STexHeader header{};
+		header.m_magic = k_stexMagic;
+		header.m_version = k_stexVersion;
+		header.m_width = uint32_t(data.m_width);
+		header.m_height = uint32_t(data.m_height);
+		header.m_channels = uint32_t(data.m_channels);
+		header.m_levelCount = uint32_t(data.m_levels.size());
+		if (!SourceStamp::make(sourcePath.string(), sourceBytes, header.m_source))
+			return false;
+
+		uint64_t offset = sizeof(STexHeader);
+		for (size_t i = 0; i < data.m_levels.size(); ++i)
+		{
+			header.m_offsets[i] = offset;
+			header.m_sizes[i] = data.m_levels[i].m_size;
+			offset += data.m_levels[i].m_size;
+		}
+
+		// Worker threads may decode the same image at once, each writes its own temporary file
+		std::string tempPath = cachePath.string() + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				std::cerr << "Cannot write texture cache: " << cachePath.string() << "\n";
+				return false;
+			}
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const TextureData::Level& level : data.m_levels)
+				out.write(reinterpret_cast<const char*>(level.m_pixels), std::streamsize(level.m_size));
+			if (!out)
+			{
+				std::cerr << "Cannot write texture cache: " << cachePath.string() << "\n";
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, cachePath, ec);
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			std::cerr << "Cannot write texture cache: " << cachePath.string() << "\n";
+			return false;
+		}
+		return true;
+	}
+}
 
 Texture::Texture() : m_textureID(0) {}
 
@@ -17,37 +268,171 @@ Texture::~Texture()
 /// Load a texture from file
 	bool Texture::loadTexture(std::filesystem::path const& filename)
 	{
-		// Check if the file exists
+		TextureData data;
+		if (!decode(filename, data))
+		{
+			throw std::runtime_error("Failed to load texture: " + filename.string());
+		}
+		return upload(data);
+	}
+
+std::filesystem::path Texture::cachePathFor(std::filesystem::path const& filename)
+{
+	return std::filesystem::path(filename).replace_extension(".stex");
+}
+
+/// Load the mip chain of an image file (any thread)
+	bool Texture::decode(std::filesystem::path const& filename, TextureData& outData)
+	{
+		std::filesystem::path cachePath = cachePathFor(filename);
+		if (loadCache(cachePath, filename, outData))
+		{
+			return true;
+		}
+
+		// The source bytes are kept mapped, the cache stamp hashes them
+		VirtualFile source;
+		if (!VirtualFileSystem::map(filename.string(), source))
+		{
+			return false;
+		}
+
+		// stbi's flip flag is global in this version, so rows are flipped here instead
+		int width, height, nrChannels;
+		unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source.data()), int(source.size()), &width, &height, &nrChannels, 0);
+		if (!data)
+		{
+			return false;
+		}
+
+		// A single colour needs no more texels than the atlas grid: the solid materials are full-HD images
+		const unsigned char* pixels = data;
+		std::vector<unsigned char> solid;
+		if (isSolid(data, width, height, nrChannels))
+		{
+			solid.resize(size_t(Texture::k_solidSize) * Texture::k_solidSize * nrChannels);
+			for (size_t i = 0; i < solid.size(); ++i)
+			{
+				solid[i] = data[i % nrChannels];
+			}
+			width = height = Texture::k_solidSize;
+			pixels = solid.data();
+		}
+
+		// Lay out the whole chain in one buffer, level 0 first
+		int levelCount = levelCountFor(width, height);
+		std::vector<TextureData::Level> levels(levelCount);
+		size_t totalSize = 0;
+		for (int i = 0, w = width, h = height; i < levelCount; ++i, w = std::max(1, w / 2), h = std::max(1, h / 2))
+		{
+			levels[i].m_width = w;
+			levels[i].m_height = h;
+			levels[i].m_size = size_t(w) * size_t(h) * size_t(nrChannels);
+			totalSize += levels[i].m_size;
+		}
+		auto storage = std::make_shared<std::vector<unsigned char>>(totalSize);
+
+		// OpenGL expects the first row at the bottom
+		size_t rowSize = size_t(width) * size_t(nrChannels);
+		unsigned char* base = storage->data();
+		for (int y = 0; y < height; ++y)
+		{
+			std::memcpy(base + size_t(y) * rowSize, pixels + size_t(height - 1 - y) * rowSize, rowSize);
+		}
+		stbi_image_free(data);
+
+		// Filter every level from the previous one
+		for (int i = 0; i < levelCount; ++i)
+		{
+			levels[i].m_pixels = base;
+			if (i + 1 < levelCount)
+			{
+				downsample(base, levels[i].m_width, levels[i].m_height, nrChannels, base + levels[i].m_size);
+			}
+			base += levels[i].m_size;
+		}
+
+		outData.m_path = filename;
+		outData.m_width = width;
+		outData.m_height = height;
+		outData.m_channels = nrChannels;
+		outData.m_levels = std::move(levels);
+		outData.m_storage = std::move(storage);
+
+		// A cache that cannot be written only costs the filtering again next time
+		writeCache(cachePath, filename, source.view(), outData);
+		return true;
+	}
+
+/// Upload decoded pixels (GL thread)
+	bool Texture::upload(const TextureData& data, TextureAtlas* atlas)
+	{
+		if (data.m_levels.empty() || !data.m_levels[0].m_pixels)
+		{
+			return false;
+		}
 		if (m_textureID) 
 		{
 			glDeleteTextures(1, &m_textureID);
 			m_textureID = 0;
+			m_gpuBytes = 0;
 		}
-		m_path = filename;
-		// Load the image
-		int width, height, nrChannels;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char* data = stbi_load(filename.string().c_str(), &width, &height, &nrChannels, 0);
-		if (!data)
+		m_path = data.m_path;
+		m_region = AtlasRegion();
+
+		// Small enough to share the atlas: no texture of its own, the atlas accounts for the memory
+		if (atlas && atlas->add(data, m_region))
 		{
-			throw std::runtime_error("Failed to load texture: " + filename.string());
+			return true;
 		}
+
 		// Determine the format
 		GLenum format = GL_RGB;
-		if (nrChannels == 1)
+		GLenum internalFormat = GL_RGB8;
+		if (data.m_channels == 1)
+		{
 			format = GL_RED;
-		else if (nrChannels == 3)
-			format = GL_RGB;
-		else if (nrChannels == 4)
+			internalFormat = GL_R8;
+		}
+		else if (data.m_channels == 2)
+		{
+			format = GL_RG;
+			internalFormat = GL_RG8;
+		}
+		else if (data.m_channels == 4)
+		{
 			format = GL_RGBA;
+			internalFormat = GL_RGBA8;
+		}
 
 		// Generate texture ID and bind it
 		glGenTextures(1, &m_textureID);
 		glBindTexture(GL_TEXTURE_2D, m_textureID);
 
-		// Set texture wrapping and filtering options
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// Rows of 1 or 3 channel images are not always 4-byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		// Every level comes prefiltered, so no glGenerateMipmap
+		GLsizei levelCount = GLsizei(data.m_levels.size());
+		if (GLExtensions::hasTextureStorage())
+		{
+			GLExtensions::texStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, data.m_width, data.m_height);
+			for (GLsizei i = 0; i < levelCount; ++i)
+			{
+				const TextureData::Level& level = data.m_levels[i];
+				glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.m_width, level.m_height, format, GL_UNSIGNED_BYTE, level.m_pixels);
+			}
+		}
+		else
+		{
+			for (GLsizei i = 0; i < levelCount; ++i)
+			{
+				const TextureData::Level& level = data.m_levels[i];
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.m_width, level.m_height, 0, format, GL_UNSIGNED_BYTE, level.m_pixels);
+			}
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+		m_gpuBytes = data.byteSize();
 
 		// Texture parameters
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -55,8 +440,31 @@ Texture::~Texture()
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-		// Unbind the texture
-		stbi_image_free(data);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return true;
+	}
 
+/// Free the GL texture, keeping the path to reload it
+	bool Texture::evict()
+	{
+		if (!m_textureID || m_path.empty())
+		{
+			return false;
+		}
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+		m_gpuBytes = 0;
 		return true;
 	}
+
+/// Reload an evicted texture (GL thread)
+	bool Texture::restore()
+	{
+		TextureData data;
+		if (!decode(m_path, data))
+		{
+			std::cerr << "Cannot restore texture: " << m_path.string() << "\n";
+			return false;
+		}
+		return upload(data);
+	}
@@ -0,0 +1,282 @@
+#include "TextureAtlas.h"
+#include "Texture.h"
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+	int rectX(const LibMath::RectangleAABB& rect) { return int(rect.getMin().getX()); }
+	int rectY(const LibMath::RectangleAABB& rect) { return int(rect.getMin().getY()); }
+	int rectWidth(const LibMath::RectangleAABB& rect) { return int(rect.getMax().getX() - rect.getMin().getX()); }
+	int rectHeight(const LibMath::RectangleAABB& rect) { return int(rect.getMax().getY() - rect.getMin().getY()); }
+
+	LibMath::RectangleAABB makeRect(int x, int y, int width, int height)
+	{
+		return LibMath::RectangleAABB(LibMath::Point2D(float(x), float(y)), LibMath::Point2D(float(x + width), float(y + height)));
+	}
+
+	// Interiors overlap (rectangles that only touch leave each other's free space alone)
+	bool overlaps(const LibMath::RectangleAABB& a, const LibMath::RectangleAABB& b)
+	{
+		return rectX(a) < rectX(b) + rectWidth(b) && rectX(b) < rectX(a) + rectWidth(a)
+			&& rectY(a) < rectY(b) + rectHeight(b) && rectY(b) < rectY(a) + rectHeight(a);
+	}
+
+	bool contains(const LibMath::RectangleAABB& outer, const LibMath::RectangleAABB& inner)
+	{
+		return rectX(inner) >= rectX(outer) && rectY(inner) >= rectY(outer)
+			&& rectX(inner) + rectWidth(inner) <= rectX(outer) + rectWidth(outer)
+			&& rectY(inner) + rectHeight(inner) <= rectY(outer) + rectHeight(outer);
+	}
+
+	size_t levelBytes(int level)
+	{
+		size_t size = size_t(TextureAtlas::k_pageSize >> level);
+		return size * size * 4;
+	}
+}
+
+// --- AtlasPacker ---
+
+AtlasPacker::AtlasPacker(int width, int height)
+	: m_width(width)
+	, m_height(height)
+{
+	m_free.push_back(makeRect(0, 0, width, height));
+}
+
+bool AtlasPacker::insert(int width, int height, LibMath::RectangleAABB& outRect)
+{
+	// Best short side fit, ties broken by the long side
+	int bestShort = INT_MAX, bestLong = INT_MAX;
+	const LibMath::RectangleAABB* best = nullptr;
+	for (const LibMath::RectangleAABB& free : m_free)
+	{
+		int leftoverX = rectWidth(free) - width;
+		int leftoverY = rectHeight(free) - height;
+		if (leftoverX < 0 || leftoverY < 0)
+			continue;
+
+		int shortSide = std::min(leftoverX, leftoverY);
+		int longSide = std::max(leftoverX, leftoverY);
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			bestShort = shortSide;
+			bestLong = longSide;
+			best = &free;
+		}
+	}
+	if (!best)
+		return false;
+
+	outRect = makeRect(rectX(*best), rectY(*best), width, height);
+	split(outRect);
+	prune();
+	m_usedArea += uint64_t(width) * uint64_t(height);
+	return true;
+}
+
+float AtlasPacker::getOccupancy() const
+{
+	return float(double(m_usedArea) / (double(m_width) * double(m_height)));
+}
+
+// Replace every free rectangle the placement overlaps by the (up to four) maximal rectangles around it
+void AtlasPacker::split(const LibMath::RectangleAABB& used)
+{
+	const int usedRight = rectX(used) + rectWidth(used);
+	const int usedTop = rectY(used) + rectHeight(used);
+
+	std::vector<LibMath::RectangleAABB> pieces;
+	for (size_t i = 0; i < m_free.size();)
+	{
+		const LibMath::RectangleAABB free = m_free[i];
+		if (!overlaps(free, used))
+		{
+			++i;
+			continue;
+		}
+
+		const int x = rectX(free), y = rectY(free);
+		const int right = x + rectWidth(free), top = y + rectHeight(free);
+		if (rectX(used) > x)
+			pieces.push_back(makeRect(x, y, rectX(used) - x, top - y));
+		if (usedRight < right)
+			pieces.push_back(makeRect(usedRight, y, right - usedRight, top - y));
+		if (rectY(used) > y)
+			pieces.push_back(makeRect(x, y, right - x, rectY(used) - y));
+		if (usedTop < top)
+			pieces.push_back(makeRect(x, usedTop, right - x, top - usedTop));
+
+		m_free[i] = m_free.back();
+		m_free.pop_back();
+	}
+	m_free.insert(m_free.end(), pieces.begin(), pieces.end());
+}
+
+// Drop free rectangles contained in another one
+void AtlasPacker::prune()
+{
+	for (size_t i = 0; i < m_free.size(); ++i)
+	{
+		for (size_t j = i + 1; j < m_free.size();)
+		{
+			if (contains(m_free[i], m_free[j]))
+			{
+				m_free.erase(m_free.begin() + j);
+				continue;
+			}
+			if (contains(m_free[j], m_free[i]))
+			{
+				m_free.erase(m_free.begin() + i);
+				--i;
+				break;
+			}
+			++j;
+		}
+	}
+}
+
+// --- TextureAtlas ---
+
+TextureAtlas::~TextureAtlas()
+{
+	if (m_textureID)
+	{
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+	}
+}
+
+bool TextureAtlas::accepts(const TextureData& data)
+{
+	return data.m_width >= k_cellSize && data.m_height >= k_cellSize
+		&& data.m_width <= k_maxEntrySize && data.m_height <= k_maxEntrySize
+		&& data.m_channels >= 1 && data.m_channels <= 4
+		&& data.m_levels.size() >= size_t(k_levelCount);
+}
+
+bool TextureAtlas::add(const TextureData& data, AtlasRegion& outRegion)
+{
+	if (!accepts(data))
+		return false;
+
+	// Tile with its border, rounded up to whole cells
+	const int cellsX = (data.m_width + 2 * k_padding + k_cellSize - 1) / k_cellSize;
+	const int cellsY = (data.m_height + 2 * k_padding + k_cellSize - 1) / k_cellSize;
+
+	LibMath::RectangleAABB cells;
+	int layer = 0;
+	while (layer < int(m_pages.size()) && !m_pages[layer].m_packer.insert(cellsX, cellsY, cells))
+		++layer;
+	if (layer == int(m_pages.size()))
+	{
+		if (layer == k_maxPages)
+			return false;
+		Page& page = m_pages.emplace_back();
+		for (int level = 0; level < k_levelCount; ++level)
+			page.m_levels[level].assign(levelBytes(level), 0);
+		if (!page.m_packer.insert(cellsX, cellsY, cells))
+		{
+			m_pages.pop_back();
+			return false;
+		}
+	}
+
+	// Copy each level into the page, the border wrapping around the texture
+	Page& page = m_pages[layer];
+	const int tileX = rectX(cells) * k_cellSize, tileY = rectY(cells) * k_cellSize;
+	const int tileWidth = cellsX * k_cellSize, tileHeight = cellsY * k_cellSize;
+	const int channels = data.m_channels;
+	for (int level = 0; level < k_levelCount; ++level)
+	{
+		const TextureData::Level& source = data.m_levels[level];
+		const int pageSize = k_pageSize >> level;
+		const int padding = k_padding >> level;
+		unsigned char* pixels = page.m_levels[level].data();
+		for (int y = 0; y < (tileHeight >> level); ++y)
+		{
+			const int sourceY = ((y - padding) % source.m_height + source.m_height) % source.m_height;
+			const unsigned char* sourceRow = source.m_pixels + size_t(sourceY) * size_t(source.m_width) * channels;
+			unsigned char* out = pixels + (size_t((tileY >> level) + y) * pageSize + size_t(tileX >> level)) * 4;
+			for (int x = 0; x < (tileWidth >> level); ++x, out += 4)
+			{
+				const int sourceX = ((x - padding) % source.m_width + source.m_width) % source.m_width;
+				const unsigned char* texel = sourceRow + size_t(sourceX) * channels;
+				// Missing channels read as GL expands R, RG and RGB textures
+				out[0] = texel[0];
+				out[1] = channels >= 2 ? texel[1] : 0;
+				out[2] = channels >= 3 ? texel[2] : 0;
+				out[3] = channels == 4 ? texel[3] : 255;
+			}
+		}
+	}
+
+	if (m_allocatedPages < int(m_pages.size()))
+		allocate();
+	else
+		uploadTile(layer, tileX, tileY, tileWidth, tileHeight);
+
+	outRegion.m_scale[0] = float(data.m_width) / float(k_pageSize);
+	outRegion.m_scale[1] = float(data.m_height) / float(k_pageSize);
+	outRegion.m_offset[0] = float(tileX + k_padding) / float(k_pageSize);
+	outRegion.m_offset[1] = float(tileY + k_padding) / float(k_pageSize);
+	outRegion.m_layer = layer;
+	++m_entryCount;
+	return true;
+}
+
+// (Re)create the array with room to spare, then send every page
+void TextureAtlas::allocate()
+{
+	m_allocatedPages = std::min(k_maxPages, std::max(int(m_pages.size()), m_allocatedPages * 2));
+	if (!m_textureID)
+		glGenTextures(1, &m_textureID);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (int level = 0; level < k_levelCount; ++level)
+	{
+		const int size = k_pageSize >> level;
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, m_allocatedPages, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		for (int layer = 0; layer < int(m_pages.size()); ++layer)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, m_pages[layer].m_levels[level].data());
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, k_levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// Send one tile of every level, straight from the page rows
+void TextureAtlas::uploadTile(int layer, int x, int y, int width, int height) const
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (int level = 0; level < k_levelCount; ++level)
+	{
+		const int pageSize = k_pageSize >> level;
+		const unsigned char* first = m_pages[layer].m_levels[level].data() + (size_t(y >> level) * pageSize + size_t(x >> level)) * 4;
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pageSize);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, layer, width >> level, height >> level, 1, GL_RGBA, GL_UNSIGNED_BYTE, first);
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureAtlas::bind(GLuint unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureID);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+size_t TextureAtlas::getGpuBytes() const
+{
+	size_t size = 0;
+	for (int level = 0; level < k_levelCount; ++level)
+		size += levelBytes(level);
+	return size * size_t(m_allocatedPages);
+}
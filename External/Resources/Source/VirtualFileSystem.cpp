@@ -0,0 +1,154 @@
+#include "VirtualFileSystem.h"
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+namespace {
+    std::string normalPath(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    // Read-only buffer over the bytes of a VirtualFile it owns
+    class VirtualFileBuffer : public std::streambuf {
+    public:
+        explicit VirtualFileBuffer(VirtualFile&& file) : m_file(std::move(file)) {
+            char* begin = const_cast<char*>(m_file.data());
+            setg(begin, begin, begin + m_file.size());
+        }
+
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+            const off_type base = direction == std::ios_base::beg ? 0 : direction == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+            return seekpos(pos_type(base + offset), std::ios_base::in);
+        }
+
+        pos_type seekpos(pos_type position, std::ios_base::openmode) override {
+            if (position < 0 || position > egptr() - eback())
+                return pos_type(off_type(-1));
+            setg(eback(), eback() + off_type(position), egptr());
+            return position;
+        }
+
+    private:
+        VirtualFile m_file;
+    };
+
+    class VirtualFileStream : public std::istream {
+    public:
+        explicit VirtualFileStream(VirtualFile&& file) : std::istream(nullptr), m_buffer(std::move(file)) {
+            rdbuf(&m_buffer);
+        }
+
+    private:
+        VirtualFileBuffer m_buffer;
+    };
+}
+
+VirtualFile::VirtualFile(VirtualFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+VirtualFile& VirtualFile::operator=(VirtualFile&& other) noexcept {
+    if (this != &other) {
+        // Both storages keep their address when moved, so the view stays valid
+        m_file     = std::move(other.m_file);
+        m_buffer   = std::move(other.m_buffer);
+        m_view     = std::exchange(other.m_view, {});
+        m_isOpen   = std::exchange(other.m_isOpen, false);
+        m_isPacked = std::exchange(other.m_isPacked, false);
+    }
+    return *this;
+}
+
+void VirtualFile::close() {
+    m_file.close();
+    std::vector<char>().swap(m_buffer);
+    m_view = {};
+    m_isOpen = false;
+    m_isPacked = false;
+}
+
+bool VirtualFileSystem::mount(const std::string& archivePath, const std::string& root) {
+    unmount();
+    std::error_code ec;
+    if (!std::filesystem::exists(archivePath, ec) || !s_archive.open(archivePath))
+        return false;
+
+    s_archiveTime = std::filesystem::last_write_time(archivePath, ec);
+    s_root = normalPath(root);
+    if (!s_root.empty() && s_root.back() != '/')
+        s_root += '/';
+    std::cout << "Mounted " << archivePath << " on " << s_root << " (" << s_archive.getEntries().size() << " files)\n";
+    return true;
+}
+
+void VirtualFileSystem::unmount() {
+    s_archive.close();
+    s_archiveTime = {};
+    s_root.clear();
+}
+
+std::string VirtualFileSystem::archiveName(const std::string& path) {
+    if (!isMounted())
+        return {};
+    std::string normal = normalPath(path);
+    if (normal.size() <= s_root.size() || normal.compare(0, s_root.size(), s_root) != 0)
+        return {};
+    return normal.substr(s_root.size());
+}
+
+const PakArchive::Entry* VirtualFileSystem::findEntry(const std::string& path) {
+    std::string name = archiveName(path);
+    return name.empty() ? nullptr : s_archive.find(name);
+}
+
+bool VirtualFileSystem::isOverridden(const std::string& path) {
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(path, ec);
+    return !ec && time > s_archiveTime;
+}
+
+bool VirtualFileSystem::exists(const std::string& path) {
+    if (findEntry(path))
+        return true;
+    std::error_code ec;
+    return std::filesystem::exists(path, ec);
+}
+
+bool VirtualFileSystem::map(const std::string& path, VirtualFile& outFile) {
+    outFile.close();
+    const PakArchive::Entry* entry = findEntry(path);
+    if (entry && isOverridden(path)) {
+        std::cout << "Loading " << path << " from disk: it is newer than the mounted archive\n";
+        entry = nullptr;
+    }
+    if (entry) {
+        if (entry->m_flags & PakArchive::Compressed) {
+            outFile.m_buffer.resize(size_t(entry->m_size));
+            if (!s_archive.inflate(*entry, outFile.m_buffer.data())) {
+                outFile.close();
+                return false;
+            }
+            outFile.m_view = { outFile.m_buffer.data(), outFile.m_buffer.size() };
+        }
+        else {
+            outFile.m_view = s_archive.getStored(*entry);
+        }
+        outFile.m_isOpen = true;
+        outFile.m_isPacked = true;
+        return true;
+    }
+
+    if (!outFile.m_file.open(path))
+        return false;
+    outFile.m_view = outFile.m_file.view();
+    outFile.m_isOpen = true;
+    return true;
+}
+
+std::unique_ptr<std::istream> VirtualFileSystem::open(const std::string& path) {
+    VirtualFile file;
+    if (!map(path, file))
+        return nullptr;
+    return std::make_unique<VirtualFileStream>(std::move(file));
+}
@@ -13,14 +13,22 @@
 #include <GLFW/glfw3.h>
 
 #include "ResourceManager.h"
+#include "AssetLoader.h"
 #include "UI_Manager.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "TextureAtlas.h"
 #include "Model.h"
 #include "Mesh.h"
+#include "MeshBatcher.h"
+#include "RenderQueue.h"
+#include "LevelData.h"
 #include "Camera.h"
 #include "Physics/Collider.h"
 #include "Physics/Physics.h"
+#include "Physics/DistanceField.h"
+#include "Physics/TriggerSystem.h"
+#include "Physics/ContactCache.h"
 #include "SceneGraph.h"
 #include "Player.h"
 #include "LibMath/Matrix/Matrix4.h"
@@ -30,6 +38,7 @@
 
 #include "Light.h"
 #include "LightInstance.h"
+#include "LightBuffer.h"
 
 class Application
 {
@@ -47,26 +56,62 @@ private:
     int             m_height;
     GLFWwindow*     m_window = nullptr;
     ResourceManager m_resourceManager;
+    Handle<Shader>  m_lightShader;      // Resolved once in loadResources
+
+    // Light shader uniforms, resolved once after link
+    struct LightShaderUniforms
+    {
+        UniformHandle               m_viewPos;
+        UniformHandle               m_matDiffuse;
+        UniformHandle               m_matSpecular;
+        UniformHandle               m_matShininess;
+        Mesh::Uniforms              m_mesh;
+    };
+    LightShaderUniforms m_lightUniforms;
+    TextureAtlas    m_textureAtlas;     // Small and single-colour textures, filled by the loader's uploads
+    AssetLoader     m_loader;
+    std::vector<AssetLoader::Completion> m_loads; // Requests of loadResources, checked once the level is up
+    size_t          m_uploadBudgetBytes = 8 * 1024 * 1024; // GPU uploads per frame while streaming
+    size_t          m_resourceBudgetBytes = 512 * 1024 * 1024; // Unreferenced resources are evicted above this
     Player          m_player;
     Camera          m_camera;
 	bool			m_isRunning = true;
     bool            m_escPressedLastFrame = false;
+    bool            m_f3PressedLastFrame = false;
+    bool            m_showProfiler = false;
 	bool            m_gameWin = false;
+    bool            m_resetRequested = false; // Set by triggers, handled once the frame's physics is done
     UI_Manager      m_uiManager;
     
     // lights
     std::vector<DirectionalLightInstance*>          m_dirLights;
     std::vector<PointLightInstance*>                m_pointLights;
     std::vector<SpotLightInstance*>                 m_spotLights;
+    LightBuffer                                     m_lightBuffer;      // "Lights" uniform block, only changed lights are re-sent
+    size_t                                          m_drawnTriangles = 0;       // Last frame, at the selected LODs
+    size_t                                          m_fullDetailTriangles = 0;  // Last frame, had every mesh used LOD 0
+    RenderQueue                                     m_renderQueue;              // This frame's draws, sorted by key
+    MeshBatcher                                     m_meshBatcher;              // Instanced draws of the level meshes
+    size_t                                          m_textureBinds = 0;         // Last frame, mesh texture binds
 
     float                                           m_lastFrame = 0.0f;
 
+    LevelData                                       m_levelData;        // Parsed or mapped once, instantiated on every reset
     std::unordered_multimap<int, Mesh*>             m_LevelMeshes;
 	std::vector<GameObject*>                        m_gameObjects;
     std::vector<GameObject*>                        m_transparent_gameObjects;
-    std::vector<Collider*>                          m_colliders;
+    Physics::BroadPhase                             m_broadPhase;
+    Physics::TriggerSystem                          m_triggers;         // END_POINT and DEATH_ZONE volumes
+    Physics::ContactCache                           m_contactCache;     // Player vs solid narrow-phase results
+    std::unique_ptr<Collider>                       m_steppedCollider;  // Player capsule at its next position
+
+    // Static level collision (OBSTACLE colliders), baked when the level is created
+    Physics::DistanceField                          m_staticField;
+    Physics::DistanceField::Settings                m_staticFieldSettings;
+    std::vector<Physics::DistanceField::Contact>    m_staticContacts;   // per-frame scratch
+    std::vector<Collider*>                          m_staticExact;      // per-frame scratch
 
-    bool    loadTexture(const std::string& name, const std::string& path);
+    bool    loadTexture(const std::string& name, const std::string& path, float opacity = 1.0f);
     bool    loadShader(const std::string& name, const std::string& vert, const std::string& frag);
     bool    loadMesh(
         Mesh** meshPtr,
@@ -75,11 +120,15 @@ private:
         const std::string& textureName
     );
     bool    loadResources();
+    bool    loadLevelData();
     bool    createLights();
+    void    updateLightBuffer();
     void    createLevel();
+    void    bakeStaticField();
     void    processInput(float deltaTime);
     void    handleCollisions(float deltaTime);
 	void    updateMovingGameObjects(float deltaTime);
     void    render();
     void    winGame();
+    void    drawProfiler();
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Audio_Manager.h"
+#include "VirtualFileSystem.h"
 #include <iostream>
 
 Audio_Manager* Audio_Manager::s_instance = nullptr;
@@ -46,7 +47,22 @@ void Audio_Manager::playSound(const char* filePath, bool loop)
 {
     if (m_isInitialized && m_soundEngine)
     {
-        m_soundEngine -> play2D(filePath, loop);
+        // Registered once under its path, from the asset archive or the disk: irrKlang keeps its own copy
+        irrklang::ISoundSource* source = m_soundEngine -> getSoundSource(filePath, false);
+        if (!source)
+        {
+            VirtualFile file;
+            if (VirtualFileSystem::map(filePath, file))
+            {
+                source = m_soundEngine -> addSoundSourceFromMemory(const_cast<char*>(file.data()), irrklang::ik_s32(file.size()), filePath, true);
+            }
+        }
+        if (!source)
+        {
+            std::cerr << "Audio_Manager cannot load sound: " << filePath << "\n";
+            return;
+        }
+        m_soundEngine -> play2D(source, loop);
     }
     else
     {
@@ -3,6 +3,7 @@
 #include "Physics/Collider.h"
 #include "Color.h"
 #include "ResourceManager.h"
+#include "MaterialInstance.h"
 #include <memory>
 
 enum class GameObjectType
@@ -28,14 +29,17 @@ public:
 		: m_mesh(mesh), m_collider(std::move(collider)), m_colorState(colorState), m_type(type), m_resourceManager(resourceManager)
 	{
 		m_collider->setGameObject(this);
+		m_collider->setLayer(getCollisionLayer());
 		m_startTransform = mesh->getModelMatrix();
 	}
 
 	void setMeshTexture();
+	uint32_t getCollisionLayer() const;
 	void updateTransform(float deltaTime, const LibMath::Matrix4& endTransform);
 	
 private:
 	ResourceManager&		m_resourceManager; // Reference to the resource manager for texture handling
+	Handle<MaterialInstance>	m_colorMaterials[4]; // Per ColorState, resolved on first use
 	LibMath::Matrix4		m_startTransform;
 	float					m_interpT = 0.0f;
 	bool					m_goingToEnd = true;
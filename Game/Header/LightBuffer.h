@@ -0,0 +1,115 @@
+#pragma once
+
+#include "LibMath/Vector/Vector3.h"
+#include "LibMath/Vector/Vector4.h"
+#include <glad/glad.h>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class Shader;
+
+// CPU mirror of the std140 "Lights" uniform block declared in LightsFrag.glsl.
+// Lights write their packed struct into the mirror, and only the bytes that actually changed are
+// sent to the GPU on upload(). A frame where no light moved costs a single buffer bind.
+class LightBuffer
+{
+public:
+    // Must match MAX_DIR, MAX_POINT and MAX_SPOT in LightsFrag.glsl
+    static constexpr int        k_maxDir = 10;
+    static constexpr int        k_maxPoint = 30;
+    static constexpr int        k_maxSpot = 10;
+
+    static constexpr GLuint     k_bindingPoint = 0;
+    static constexpr const char* k_blockName = "Lights";
+
+    // std140 images of the GLSL structs, padding included
+    struct DirLight
+    {
+        LibMath::Vector3    m_direction;
+        float               m_pad = 0.0f;
+        LibMath::Vector4    m_ambient;
+        LibMath::Vector4    m_diffuse;
+        LibMath::Vector4    m_specular;
+    };
+
+    struct PointLight
+    {
+        LibMath::Vector3    m_position;
+        float               m_constant = 1.0f;
+        LibMath::Vector4    m_ambient;
+        LibMath::Vector4    m_diffuse;
+        LibMath::Vector4    m_specular;
+        float               m_linear = 0.0f;
+        float               m_quadratic = 0.0f;
+        float               m_pad[2] = { 0.0f, 0.0f };
+    };
+
+    struct SpotLight
+    {
+        LibMath::Vector3    m_position;
+        float               m_constant = 1.0f;
+        LibMath::Vector3    m_direction;
+        float               m_linear = 0.0f;
+        LibMath::Vector4    m_ambient;
+        LibMath::Vector4    m_diffuse;
+        LibMath::Vector4    m_specular;
+        float               m_quadratic = 0.0f;
+        float               m_cutOff = 0.0f;
+        float               m_outerCutOff = 0.0f;
+        float               m_pad = 0.0f;
+    };
+
+    LightBuffer();
+
+    LightBuffer(const LightBuffer&) = delete;
+    LightBuffer& operator=(const LightBuffer&) = delete;
+
+    // Create the GL buffer and upload the whole mirror once. Needs a current context,
+    // and destroy() must run before that context goes away.
+    bool            init();
+    void            destroy();
+
+    // Point the program's "Lights" block at k_bindingPoint. Returns false if the program has no such block.
+    static bool     bindBlock(const Shader& shader);
+
+    // Light counts are clamped to the array sizes; lights past the end are dropped.
+    void            setCounts(int dirCount, int pointCount, int spotCount);
+    void            setDirLight(int index, const DirLight& light);
+    void            setPointLight(int index, const PointLight& light);
+    void            setSpotLight(int index, const SpotLight& light);
+
+    // Send the changed ranges (if any) and bind the buffer to k_bindingPoint.
+    void            upload();
+
+    // Bytes and glBufferSubData calls of the last upload()
+    size_t          getUploadedBytes() const { return m_uploadedBytes; }
+    size_t          getUploadCount() const { return m_uploadCount; }
+
+private:
+    struct Block
+    {
+        int32_t     m_numDir = 0;
+        int32_t     m_numPoint = 0;
+        int32_t     m_numSpot = 0;
+        int32_t     m_pad = 0;
+        DirLight    m_dirLights[k_maxDir];
+        PointLight  m_pointLights[k_maxPoint];
+        SpotLight   m_spotLights[k_maxSpot];
+    };
+
+    struct Range
+    {
+        size_t      m_begin;
+        size_t      m_end;
+    };
+
+    // Copy into the mirror at offset, and mark the range dirty only if the bytes differ
+    void            write(size_t offset, const void* data, size_t size);
+
+    Block               m_block;
+    GLuint              m_buffer = 0;
+    std::vector<Range>  m_dirty;
+    size_t              m_uploadedBytes = 0;
+    size_t              m_uploadCount = 0;
+};
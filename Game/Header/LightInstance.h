@@ -2,12 +2,13 @@
 
 #include "Light.h"
 #include "LibMath/Matrix/Matrix4.h"
-#include "Shader.h"
 #include "LightInstance.h"
 #include <vector>
 #include <string>
 
 
+class LightBuffer;
+class LevelData;
 class DirectionalLightInstance;
 class PointLightInstance;
 class SpotLightInstance;
@@ -23,9 +24,14 @@ public:
     Light*                      getLight() const;
 
 
-    /// Upload this lights uniforms into the currently-bound shader
-    /// idx is the index in the corresponding uniform array
-    virtual void                uploadUniforms(Shader& shader, int idx) const = 0;
+    /// Changes since the light was last written to the light buffer.
+    /// setTransform marks the light dirty; call markDirty after editing its Light resource.
+    bool                        isDirty() const;
+    void                        markDirty();
+
+    /// Write this light into its slot of the light buffer and clear the dirty flag
+    /// idx is the index in the corresponding light array
+    virtual void                writeTo(LightBuffer& buffer, int idx) = 0;
 
     static bool LoadInstances(
         const std::string& filename,
@@ -35,30 +41,38 @@ public:
         std::vector<SpotLightInstance*>& outSpot
     );
 
-    static std::string          stripInvisible(const std::string& in);
+    /// Same, from the lights of a level already parsed or mapped from a compiled .slvl
+    static bool LoadInstances(
+        const LevelData& level,
+        ResourceManager& manager,
+        std::vector<DirectionalLightInstance*>& outDir,
+        std::vector<PointLightInstance*>& outPoint,
+        std::vector<SpotLightInstance*>& outSpot
+    );
 
 protected:
     Light*               m_light;
     LibMath::Matrix4     m_transform;
+    bool                 m_dirty = true;
 };
 
 class DirectionalLightInstance : public LightInstance
 {
 public:
     explicit DirectionalLightInstance(Light* lightResource);
-    void    uploadUniforms(Shader& shader, int idx) const override;
+    void    writeTo(LightBuffer& buffer, int idx) override;
 };
 
 class PointLightInstance : public LightInstance
 {
 public:
     explicit PointLightInstance(Light* lightResource);
-    void    uploadUniforms(Shader& shader, int idx) const override;
+    void    writeTo(LightBuffer& buffer, int idx) override;
 };
 
 class SpotLightInstance : public LightInstance
 {
 public:
     explicit SpotLightInstance(Light* lightResource);
-    void    uploadUniforms(Shader& shader, int idx) const override;
+    void    writeTo(LightBuffer& buffer, int idx) override;
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CollisionLayer.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physics
+{
+    class Collider;
+
+    // Broad-phase collider registry, bucketed by layer.
+    // Queries test the filter once per bucket, so colliders on rejected layers are never visited.
+    // A collider's layer must be set before it is added; to change it, remove and add it again.
+    class BroadPhase
+    {
+    public:
+        void        add(Collider* collider);
+        void        remove(Collider* collider);
+        void        clear();
+
+        // Returns the number of registered colliders.
+        size_t      size() const;
+
+        // Calls visitor(Collider&) for every collider whose layer passes the filter.
+        template<typename Visitor>
+        void        forEach(const QueryFilter& filter, Visitor&& visitor) const
+        {
+            for (const Bucket& bucket : m_buckets)
+            {
+                if (!filter.accepts(bucket.m_layer))
+                    continue;
+
+                for (Collider* collider : bucket.m_colliders)
+                    visitor(*collider);
+            }
+        }
+
+    private:
+        struct Bucket
+        {
+            uint32_t                m_layer = LAYER_NONE;
+            std::vector<Collider*>  m_colliders;
+        };
+
+        std::vector<Bucket>     m_buckets;
+    };
+}
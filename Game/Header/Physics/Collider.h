@@ -3,6 +3,7 @@
 #include "LibMath/Geometry3D.h"
 #include "Mesh.h"               
 #include "Physics.h" 
+#include "CollisionLayer.h"
 #include <memory>               
 #include <optional>             
 
@@ -63,16 +64,28 @@ namespace Physics
         GameObject*                         getGameObject() const;
 		void                                setGameObject(GameObject* gameObject);
 
+        // Unique handle, never reused, used to key per-pair caches.
+        uint32_t                            getId() const { return m_id; }
+
+        // Layer bits used by broad-phase filtering (see CollisionLayer.h).
+        uint32_t                            getLayer() const { return m_layer; }
+        void                                setLayer(uint32_t layer) { m_layer = layer; }
+
         virtual void                        updateBounds() = 0;
 
+        // World-space axis-aligned box enclosing the collider, for broad-phase tests.
+        virtual LibMath::Prism3DAABB        getBounds() const = 0;
+
     protected:
         // m_colliderObject is now primarily for compatibility with `getObject()`.
         // Derived classes will directly hold their specific LibMath objects.
         std::unique_ptr<LibMath::Object3D>  m_colliderObject;
-		GameObject*                         m_gameObject; // Pointer to the mesh data, if applicable.
+		GameObject*                         m_gameObject = nullptr; // Pointer to the mesh data, if applicable.
 
     private:
         ColliderType                        m_type; // Type is now private and managed internally.
+        uint32_t                            m_id;
+        uint32_t                            m_layer = LAYER_OBSTACLE;
     };
 
     // --- Derived Collider Classes ---
@@ -97,6 +110,7 @@ namespace Physics
 
 		// Update the AABB bounds based on the current state of the collider.
         void                                    updateBounds() override;
+        LibMath::Prism3DAABB                    getBounds() const override { return m_aabb; }
 
     private:
         LibMath::Prism3DAABB    m_aabb; // BoxCollider directly owns its AABB.
@@ -122,6 +136,7 @@ namespace Physics
 
 		// Update the Sphere bounds based on the current state of the collider.
 		void                                    updateBounds() override;
+        LibMath::Prism3DAABB                    getBounds() const override;
 
     private:
         LibMath::Sphere3D   m_sphere; // SphereCollider directly owns its Sphere.
@@ -148,6 +163,7 @@ namespace Physics
 
 		// Update the Capsule bounds based on the current state of the collider.
 		void                                        updateBounds() override;
+        LibMath::Prism3DAABB                        getBounds() const override;
 
 		void                                        updateCapsule(const LibMath::Point3D& p1, const LibMath::Point3D& p2, float r);
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Color.h"
+#include <cstdint>
+
+namespace Physics
+{
+    // Layer bits carried by every collider.
+    // A collider has exactly one type bit, plus a colour bit when the phone colour can let the player pass through it.
+    enum CollisionLayer : uint32_t
+    {
+        LAYER_NONE              = 0,
+
+        // Type bits (one per GameObjectType, plus the player)
+        LAYER_OBSTACLE          = 1u << 0,
+        LAYER_DOOR              = 1u << 1,
+        LAYER_BUTTON            = 1u << 2,
+        LAYER_MOVING_OBJECT     = 1u << 3,
+        LAYER_END_POINT         = 1u << 4,
+        LAYER_DEATH_ZONE        = 1u << 5,
+        LAYER_PLAYER            = 1u << 6,
+
+        // Colour bits, in ColorState order (see colorLayer)
+        LAYER_COLOR_INACTIVE    = 1u << 8,
+        LAYER_COLOR_RED         = 1u << 9,
+        LAYER_COLOR_BLUE        = 1u << 10,
+        LAYER_COLOR_YELLOW      = 1u << 11,
+
+        // Common groups
+        LAYER_INTERACTABLE      = LAYER_BUTTON | LAYER_MOVING_OBJECT,
+        LAYER_SOLID             = LAYER_OBSTACLE | LAYER_DOOR | LAYER_BUTTON | LAYER_MOVING_OBJECT,
+        LAYER_TRIGGER           = LAYER_END_POINT | LAYER_DEATH_ZONE,
+        LAYER_ALL               = 0xFFFFFFFFu
+    };
+
+    // Returns the colour bit matching a ColorState.
+    inline uint32_t colorLayer(ColorState state)
+    {
+        return LAYER_COLOR_INACTIVE << static_cast<uint32_t>(state);
+    }
+
+    // Query mask: a collider is visited only if its layer shares a bit with m_include
+    // and shares none with m_exclude.
+    struct QueryFilter
+    {
+        uint32_t    m_include = LAYER_ALL;
+        uint32_t    m_exclude = LAYER_NONE;
+
+        bool        accepts(uint32_t layer) const { return (layer & m_include) != 0 && (layer & m_exclude) == 0; }
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "LibMath/Vector/Vector3.h"
+#include <unordered_map>
+#include <cstdint>
+
+namespace Physics
+{
+    class Collider;
+
+    // Persistent narrow-phase results, keyed by the (ordered) pair of collider ids.
+    // Each entry keeps the last contact normal or, when the pair was apart, a separating axis
+    // and a lower bound of the gap. The next frame, the relative motion of the two bounds is compared
+    // with that gap first: pairs that cannot have closed it, and resting contacts that did not move,
+    // reuse the cached result instead of running the narrow phase again. Pairs that moved more are
+    // re-tested on the cached axis, and only go to the narrow phase once their bounds meet on it.
+    class ContactCache
+    {
+    public:
+        struct Stats
+        {
+            uint32_t    m_hits = 0;     // Results reused from the cache
+            uint32_t    m_misses = 0;   // Full narrow-phase tests
+
+            float       hitRate() const { return m_hits + m_misses ? float(m_hits) / float(m_hits + m_misses) : 0.0f; }
+        };
+
+        // Same contract as Collider::checkCollision, going through the cache.
+        bool            test(const Collider& a, const Collider& b, LibMath::Vector3& outNormal);
+
+        // Start a new frame: the frame counters are reset and pairs left untested are dropped.
+        void            beginFrame();
+        void            clear();
+
+        const Stats&    getFrameStats() const { return m_frameStats; }
+        const Stats&    getTotalStats() const { return m_totalStats; }
+        size_t          size() const { return m_entries.size(); }
+
+    private:
+        struct Entry
+        {
+            LibMath::Vector3    m_normal;           // Contact normal, when touching
+            LibMath::Vector3    m_axis;             // Separating axis, when apart
+            float               m_separation = 0.0f;// Lower bound of the gap along m_axis
+            LibMath::Vector3    m_offset;           // Centre of b's bounds minus centre of a's
+            LibMath::Vector3    m_extents;          // Sum of both half extents
+            uint32_t            m_frame = 0;        // Last frame the pair was tested
+            bool                m_touching = false;
+        };
+
+        static uint64_t pairKey(const Collider& a, const Collider& b);
+
+        std::unordered_map<uint64_t, Entry>     m_entries;
+        uint32_t                                m_frame = 0;
+        Stats                                   m_frameStats;
+        Stats                                   m_totalStats;
+    };
+}
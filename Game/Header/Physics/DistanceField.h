@@ -0,0 +1,82 @@
+#pragma once
+
+#include "LibMath/Geometry3D.h"
+#include "LibMath/Vector/Vector3.h"
+#include <vector>
+#include <cstdint>
+
+namespace Physics
+{
+    class Collider;
+    class BoxCollider;
+
+    // Sparse, bricked signed distance field baked over static box colliders.
+    // Space is cut into bricks of m_brickSize^3 voxels. Only bricks close to a surface store samples
+    // (distance plus the nearest collider); the others only keep a coarse distance.
+    // Contacts use the field gradient where all eight surrounding samples agree on the nearest collider.
+    // Near creases, and in bricks touching features thinner than two voxels, the nearby colliders are
+    // handed back for an exact test instead.
+    class DistanceField
+    {
+    public:
+        struct Settings
+        {
+            float   m_voxelSize = 0.25f;    // World size of one voxel
+            int     m_brickSize = 8;        // Voxels along one brick edge
+            float   m_bandWidth = 1.0f;     // Distances are stored up to this far from a surface
+        };
+
+        struct Contact
+        {
+            LibMath::Vector3    m_normal;   // Points away from the static geometry
+            float               m_depth = 0.0f;
+        };
+
+        // Bake the field over the given static box colliders.
+        void                bake(const std::vector<BoxCollider*>& boxes, const Settings& settings);
+        // Point the baked field at new colliders for the same boxes (a level rebuilt from the same data),
+        // without baking again. False if they differ in count, order or bounds from the baked ones.
+        bool                rebind(const std::vector<BoxCollider*>& boxes);
+        void                clear();
+        bool                isBaked() const { return !m_brickIndex.empty(); }
+
+        // Trilinear distance sample, and the same sample with its gradient.
+        float               sample(const LibMath::Vector3& point) const;
+        float               sample(const LibMath::Vector3& point, LibMath::Vector3& outGradient) const;
+
+        // Contacts between a capsule and the baked geometry, sampled along the capsule segment.
+        // Colliders that need the exact narrow phase (creases, thin features) are appended to outExact
+        // without duplicates and must be tested by the caller.
+        void                queryCapsule(
+            const LibMath::Capsule3D& capsule,
+            std::vector<Contact>& outContacts,
+            std::vector<Collider*>& outExact
+        ) const;
+
+        // Number of colliders baked, of bricks holding samples, and the memory they use.
+        size_t              getColliderCount() const { return m_colliders.size(); }
+        size_t              getBrickCount() const { return m_brickThin.size(); }
+        size_t              getMemoryUsage() const;
+
+    private:
+        int                 brickAt(const LibMath::Vector3& point, int& outCell) const;
+        float               interpolate(int brick, int cell, const LibMath::Vector3& point, LibMath::Vector3& outGradient, uint16_t* outNearest) const;
+        void                addExact(Collider* collider, std::vector<Collider*>& outExact) const;
+
+        Settings                m_settings;
+        LibMath::Vector3        m_origin;
+        int                     m_dims[3] = { 0, 0, 0 };   // Grid size in bricks
+        float                   m_brickWorldSize = 0.0f;
+        float                   m_quantScale = 1.0f;        // Stored value * scale = distance
+
+        std::vector<int32_t>    m_brickIndex;   // Per grid cell: brick slot, or -1 when not stored
+        std::vector<float>      m_coarse;       // Per grid cell: conservative distance for unstored cells
+        std::vector<int16_t>    m_samples;      // (m_brickSize + 1)^3 quantized samples per stored brick
+        std::vector<uint16_t>   m_nearest;      // Nearest collider (index into m_colliders) per sample
+        std::vector<Collider*>  m_colliders;
+        std::vector<LibMath::Prism3DAABB> m_colliderBounds;    // Per collider: its bounds when baked, checked by rebind
+        std::vector<uint8_t>    m_brickThin;    // Per stored brick: touches a thin feature
+        std::vector<uint32_t>   m_exactStart;   // Per stored brick: range into m_exactColliders
+        std::vector<uint16_t>   m_exactColliders;   // Indices into m_colliders
+    };
+}
@@ -4,6 +4,7 @@
 
 #include "RaycastHit.h"
 #include "Collider.h"
+#include "BroadPhase.h"
 #include <vector>
 #include <memory> 
 #include <optional>
@@ -15,10 +16,12 @@ namespace Physics
     class PhysicsManager
     {
     public:
-        // Raycast: returns the first hit, if any, along the ray
+        // Raycast: returns the first hit, if any, along the ray.
+        // Only colliders whose layer passes the filter are tested.
         static std::optional<RaycastHit>    Raycast(
             const LibMath::Line3D& ray,
-            const std::vector<Collider*>& colliders,
+            const BroadPhase& colliders,
+            const QueryFilter& filter = QueryFilter(),
             float maxDistance = 1000.0f
         );
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "LibMath/Geometry3D.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace Physics
+{
+    class Collider;
+
+    // Non-solid trigger volumes, kept out of the solid broad-phase.
+    // Triggers are stored in a uniform hash grid and only tested against the registered dynamic bodies,
+    // so a trigger nothing is near costs nothing per frame.
+    // Callbacks fire on state change (enter/exit), stay fires every frame while a body is inside.
+    // Triggers are treated as static: to move one, clear and add it again.
+    class TriggerSystem
+    {
+    public:
+        using Callback = std::function<void(const Collider& trigger, const Collider& body)>;
+
+        explicit TriggerSystem(float cellSize = 4.0f);
+
+        // Register a trigger volume (non-owning). onExit and onStay are optional.
+        void        addTrigger(const Collider* trigger, Callback onEnter, Callback onExit = {}, Callback onStay = {});
+
+        // Register a dynamic body (non-owning) tested against the triggers.
+        void        addBody(const Collider* body);
+        // Unregister a body. Its active pairs are dropped without firing onExit.
+        void        removeBody(const Collider* body);
+
+        // Remove all triggers, bodies and active pairs. Safe to call from a callback.
+        void        clear();
+
+        // Test every body against nearby triggers and fire the events of this frame.
+        void        update();
+
+        size_t      getTriggerCount() const { return m_triggers.size(); }
+
+    private:
+        struct Trigger
+        {
+            const Collider*         m_collider = nullptr;
+            LibMath::Prism3DAABB    m_bounds;
+            Callback                m_onEnter;
+            Callback                m_onExit;
+            Callback                m_onStay;
+            uint32_t                m_visitStamp = 0;   // Dedup when a trigger spans several cells
+        };
+
+        struct Pair
+        {
+            uint32_t            m_trigger = 0;
+            const Collider*     m_body = nullptr;
+
+            bool operator<(const Pair& other) const
+            {
+                return m_trigger != other.m_trigger ? m_trigger < other.m_trigger : m_body < other.m_body;
+            }
+            bool operator==(const Pair& other) const { return m_trigger == other.m_trigger && m_body == other.m_body; }
+        };
+
+        enum class EventType { ENTER, STAY, EXIT };
+
+        struct Event
+        {
+            EventType   m_type;
+            Pair        m_pair;
+        };
+
+        uint64_t    cellKey(int x, int y, int z) const;
+        void        cellRange(const LibMath::Prism3DAABB& bounds, int outMin[3], int outMax[3]) const;
+
+        float                                           m_cellSize;
+        std::vector<Trigger>                            m_triggers;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+        std::vector<const Collider*>                    m_bodies;
+
+        std::vector<Pair>                               m_active;   // Sorted pairs overlapping last frame
+        std::vector<Pair>                               m_current;  // Per-frame scratch
+        std::vector<Event>                              m_events;   // Per-frame scratch
+        uint32_t                                        m_visitStamp = 0;
+        uint32_t                                        m_generation = 0; // Bumped by clear()
+    };
+}
@@ -15,10 +15,10 @@ public:
 
     void                reset();
 
-    void                handleInput(GLFWwindow* window, float deltaTime, const std::vector<Collider*>& colliders);
+    void                handleInput(GLFWwindow* window, float deltaTime, const BroadPhase& colliders);
     void                updatePosition(float deltaTime);
     void                updateCamera();
-    void                performRaycast(GLFWwindow* window, const std::vector<Collider*>& colliders);
+    void                performRaycast(GLFWwindow* window, const BroadPhase& colliders);
 
     void                setCamera(Camera* camera);
     void                setCollider(std::unique_ptr<Collider> collider);
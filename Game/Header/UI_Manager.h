@@ -12,6 +12,8 @@ public:
     void drawPhone(const Phone& phone, float radius = 200.0f);
 	void drawCursor(float radius = 10.0f);
     void drawMenu(GLFWwindow* window, std::function<void()> onRestartClicked, const char* text);
+    // Small overlay in the top-left corner, drawContent adds its lines
+    void drawProfiler(std::function<void()> drawContent);
 
 };
 
@@ -1,5 +1,11 @@
 ﻿#include "Application.h"
 #include "Audio_Manager.h"
+#include "GLExtensions.h"
+#include "VirtualFileSystem.h"
+
+#ifndef ASSET_ARCHIVE
+#define ASSET_ARCHIVE "../../Assets/Assets.pak"
+#endif
 
 Application::Application(int width, int height)
     : m_width(width)
@@ -35,6 +41,7 @@ bool Application::init()
     if (!m_window) return false;
     glfwMakeContextCurrent(m_window);
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return false;
+    GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
 	// ImGui setup
     IMGUI_CHECKVERSION();
@@ -58,6 +65,15 @@ bool Application::init()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    m_resourceManager.setMemoryBudget(m_resourceBudgetBytes);
+
+    // 16-byte vertices instead of 32, the shaders are built with the matching decode
+    Model::setVertexFormat(Model::VertexFormat::Compressed);
+    // Only collision proxies stay in RAM, the render data lives on the GPU
+    Model::setResidency(Model::Residency::GpuOnly);
+    // One mapped archive of cooked assets when AssetCooker built it, loose files otherwise
+    if (!VirtualFileSystem::mount(ASSET_ARCHIVE, "../../Assets"))
+        std::cout << "No asset archive, loading loose files\n";
     if (!loadResources())
         return false;
 
@@ -67,42 +83,37 @@ bool Application::init()
 }
 
 /// Load resources: textures, shaders, meshes
+/// Textures and models are decoded/parsed on the loader's workers while the shader compiles here;
+/// the level only waits for the models it places, then every request is checked before the first frame.
 bool Application::loadResources()
 {
     //TEXTURES
 
-    if (!loadTexture("transparent_gray_color", "../../Assets/Textures/Solid_gray.png")) 
+    // Small images (the single-colour ones once decoded) become tiles of one atlas instead of textures of their own
+    m_loader.setTextureAtlas(&m_textureAtlas);
+
+    // Names sharing an image share its texture, only their opacity differs
+    if (!loadTexture("transparent_gray_color", "../../Assets/Textures/Solid_gray.png", 0.3f)) 
         return false;
-    m_resourceManager.get<Texture>("transparent_gray_color")->setOpacity(0.3);
     if (!loadTexture("gray_color", "../../Assets/Textures/Solid_gray.png"))
         return false;
-    if (!loadTexture("invisible", "../../Assets/Textures/Solid_gray.png"))
+    if (!loadTexture("invisible", "../../Assets/Textures/Solid_gray.png", 0.0f))
         return false;
-    m_resourceManager.get<Texture>("invisible")->setOpacity(0);
     if (!loadTexture("dragon_stamp", "../../Assets/Textures/dragon_stamp.jpg"))
         return false;
     if (!loadTexture("red_color", "../../Assets/Textures/red_solid.jpg"))
         return false;
-    if (!loadTexture("transparent_red_color", "../../Assets/Textures/red_solid.jpg"))
+    if (!loadTexture("transparent_red_color", "../../Assets/Textures/red_solid.jpg", 0.3f))
         return false;
-    m_resourceManager.get<Texture>("transparent_red_color")->setOpacity(0.3);
     if (!loadTexture("blue_color", "../../Assets/Textures/blue_solid.jpg"))
         return false;
-    if (!loadTexture("transparent_blue_color", "../../Assets/Textures/blue_solid.jpg"))
+    if (!loadTexture("transparent_blue_color", "../../Assets/Textures/blue_solid.jpg", 0.3f))
         return false;
-    m_resourceManager.get<Texture>("transparent_blue_color")->setOpacity(0.3);
     if (!loadTexture("jade_color", "../../Assets/Textures/jade_2.jpg"))
         return false;
     if (!loadTexture("yellow_color", "../../Assets/Textures/yellow_solid.jpg"))
         return false;
-
-    if (!loadTexture("transparent_yellow_color", "../../Assets/Textures/yellow_solid.jpg"))
-        return false;
-    m_resourceManager.get<Texture>("transparent_yellow_color")->setOpacity(0.3);
-
-    //SHADERS
-
-    if (!loadShader("LightShader", "../../Assets/Shaders/LightsVert.glsl", "../../Assets/Shaders/LightsFrag.glsl")) 
+    if (!loadTexture("transparent_yellow_color", "../../Assets/Textures/yellow_solid.jpg", 0.3f))
         return false;
 
     //MESHES
@@ -120,7 +131,32 @@ bool Application::loadResources()
     //if (!loadMesh(nullptr, "dragon", "../../Assets/Meshes/dragon.obj", "jade_color"))
       //  return false;
 
-    if (!Mesh::loadInstances( "../../Assets/Levels/LevelTest.txt", m_LevelMeshes, m_resourceManager))
+    //SHADERS (compiled here while the workers parse and decode)
+
+    Shader::setCacheDirectory("../../Assets/Shaders/Cache");
+
+    // The level's meshes are drawn a group at a time by m_meshBatcher
+    if (!loadShader("LightShader", "../../Assets/Shaders/LightsVert.glsl", "../../Assets/Shaders/LightsFrag.glsl")) 
+        return false;
+    m_lightShader = m_resourceManager.find<Shader>("LightShader");
+    if (Shader* lightShader = m_resourceManager.get(m_lightShader))
+    {
+        m_lightUniforms.m_viewPos       = lightShader -> uniform("uViewPos");
+        m_lightUniforms.m_matDiffuse    = lightShader -> uniform("uMatDiffuse");
+        m_lightUniforms.m_matSpecular   = lightShader -> uniform("uMatSpecular");
+        m_lightUniforms.m_matShininess  = lightShader -> uniform("uMatShininess");
+        m_lightUniforms.m_mesh          = Mesh::Uniforms::resolve(*lightShader);
+
+        // Block bindings are not part of the program binary, so this runs after every link
+        if (!LightBuffer::bindBlock(*lightShader))
+            return false;
+    }
+    if (!m_lightBuffer.init())
+        return false;
+
+    if (!loadLevelData())
+        return false;
+    if (!Mesh::loadInstances(m_levelData, m_LevelMeshes, m_resourceManager, &m_loader))
         return false;
 
     Audio_Manager::getInstance() -> playSound("../../Assets/Sounds/Music/funny_background_music.wav", true);
@@ -128,18 +164,30 @@ bool Application::loadResources()
     createLights();
     createLevel();
 
+    // Then the rest (textures, unplaced models): the game does not start with a resource that failed
+    bool loaded = true;
+    for (const AssetLoader::Completion& load : m_loads)
+        loaded = m_loader.wait(load) && loaded;
+    m_loads.clear();
+    if (!loaded)
+    {
+        std::cerr << "Failed to load textures or models\n";
+        return false;
+    }
+
     return true;
 }
 
-// Load a texture from file
-bool Application::loadTexture(const std::string& name, const std::string& path)
+// Register a material instance for an image, queueing the texture load (decoded on a worker,
+// uploaded by the frame loop) only the first time the image is seen
+bool Application::loadTexture(const std::string& name, const std::string& path, float opacity)
 {
-    auto* texture = m_resourceManager.create<Texture>(name);
-    if (!texture -> loadTexture(path)) 
-    {
-        std::cerr << "Texture load failed: " << path << "\n";
-        return false;
-    }
+    bool isNew = false;
+    Texture* texture = m_resourceManager.acquireTexture(path, isNew);
+    if (isNew)
+        m_loads.push_back(m_loader.loadTexture(path, texture, path));
+
+    m_resourceManager.create<MaterialInstance>(name) -> set(texture, opacity);
     return true;
 }
 
@@ -147,6 +195,8 @@ bool Application::loadTexture(const std::string& name, const std::string& path)
 bool Application::loadShader(const std::string& name, const std::string& vert, const std::string& frag)
 {
     auto* shader = m_resourceManager.create<Shader>(name);
+    if (Model::getVertexFormat() == Model::VertexFormat::Compressed)
+        shader -> addDefine("COMPRESSED_VERTICES");
     if (!shader -> setVertexShader(vert) || !shader->setFragmentShader(frag) || !shader->link()) 
     {
         std::cerr << "Shader load failed: " << vert << " / " << frag << "\n";
@@ -161,20 +211,15 @@ bool Application::loadMesh(
     const std::string& textureName
 )
 {
-    // 1) create & load the Model
+    // 1) create the Model here (GL objects), parse it on a worker
     auto* model = m_resourceManager.create<Model>(modelName);
-    if (!model -> loadFromOBJ(objPath)) {
-        std::cerr << "Model load failed: " << objPath << "\n";
-        return false;
-    }
-    model -> uploadToGPU();
+    m_loads.push_back(m_loader.loadModel(modelName, model, objPath));
 
     // 2) create the Mesh, give it its texture
     if (meshPtr)
     {
         *meshPtr = new Mesh(model);
-        Texture* tex = m_resourceManager.get<Texture>(textureName);
-        (*meshPtr) -> setTexture(tex);
+        (*meshPtr) -> setMaterial(m_resourceManager.get<MaterialInstance>(textureName));
     }
     
     return true;
@@ -183,7 +228,7 @@ bool Application::loadMesh(
 bool Application::createLights()
 {
     if (!LightInstance::LoadInstances(
-        "../../Assets/Levels/lights.txt",
+        m_levelData,
         m_resourceManager,
         m_dirLights,
         m_pointLights,
@@ -192,6 +237,20 @@ bool Application::createLights()
         std::cerr << "Failed to load lights\n";
         return false;
     }
+    return true;
+}
+// Level layout: the compiled .slvl when it is up to date with both text files, the text files otherwise.
+// Kept for the whole run, resetGame instantiates the level again from it.
+bool Application::loadLevelData()
+{
+    const std::string levelPath = "../../Assets/Levels/LevelTest.txt";
+    const std::string lightsPath = "../../Assets/Levels/lights.txt";
+
+    if (m_levelData.loadCompiled(LevelData::compiledPathFor(levelPath), levelPath, lightsPath))
+        return true;
+
+    std::cout << "No up-to-date compiled level, parsing " << levelPath << " (LevelCompiler builds it)\n";
+    return m_levelData.parseLevelText(levelPath) && m_levelData.parseLightsText(lightsPath);
 }
 // Create level
 void Application::createLevel()
@@ -246,15 +305,51 @@ void Application::createLevel()
 
         auto newGameObject = new GameObject(mesh, std::move(collider), color, type, m_resourceManager);
 
-        // Add collider to m_colliders if it exists
+        // Register the collider: end points and death zones are triggers, everything else is solid
         if (newGameObject->m_collider)
         {
-            m_colliders.push_back(newGameObject->m_collider.get());
+            if (type == GameObjectType::DEATH_ZONE)
+            {
+                // Resetting rebuilds the level, so only flag it here
+                m_triggers.addTrigger(newGameObject->m_collider.get(),
+                    [this](const Collider&, const Collider&) { m_resetRequested = true; });
+            }
+            else if (type == GameObjectType::END_POINT)
+            {
+                m_triggers.addTrigger(newGameObject->m_collider.get(),
+                    [this](const Collider&, const Collider&) { winGame(); });
+            }
+            else
+            {
+                m_broadPhase.add(newGameObject->m_collider.get());
+            }
         }
 
         // Move the newly created GameObject into the vector
         m_gameObjects.push_back(newGameObject);
     }
+
+    // The player collider is recreated on reset, so register it with the level
+    m_triggers.addBody(m_player.getCollider());
+
+    bakeStaticField();
+}
+// Bake the distance field over the static level geometry. A reset rebuilds the same boxes from the same
+// level data, the baked field is then only pointed at the new colliders.
+void Application::bakeStaticField()
+{
+    std::vector<BoxCollider*> staticBoxes;
+    for (auto* gameObject : m_gameObjects)
+    {
+        if (gameObject -> m_type == GameObjectType::OBSTACLE && gameObject -> m_collider &&
+            gameObject -> m_collider -> getType() == ColliderType::BOX)
+        {
+            staticBoxes.push_back(static_cast<BoxCollider*>(gameObject -> m_collider.get()));
+        }
+    }
+
+    if (!m_staticField.rebind(staticBoxes))
+        m_staticField.bake(staticBoxes, m_staticFieldSettings);
 }
 // Run the application
 void Application::run()
@@ -275,19 +370,32 @@ void Application::run()
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // Finish streaming resources, a bounded amount per frame
+        m_loader.drainUploads(m_uploadBudgetBytes);
+        m_resourceManager.update();
+
         // Process application-level input (like pausing)
         processInput(deltaTime); // This now only toggles m_isRunning and cursor
 
         if (m_isRunning)
         {
             // Game logic and rendering when running
-            m_player.handleInput(m_window, deltaTime, m_colliders);
+            m_player.handleInput(m_window, deltaTime, m_broadPhase);
             handleCollisions(deltaTime);
             m_player.updatePosition(deltaTime);
+            m_triggers.update();
+            if (m_resetRequested)
+            {
+                resetGame();
+            }
             updateMovingGameObjects(deltaTime);
             render(); 
             m_uiManager.drawPhone(m_player.getPhone());
             m_uiManager.drawCursor(5);
+            if (m_showProfiler)
+            {
+                drawProfiler();
+            }
         }
 		else if (!m_isRunning && m_gameWin) // Game is won, draw the win menu
         {
@@ -315,50 +423,86 @@ void    Application::handleCollisions(float deltaTime)
 {
     LibMath::Vector3 collisionNormal;
     m_player.m_grounded = false;
-    std::unique_ptr<Collider> steppedCollider;
+    m_contactCache.beginFrame();
 
-    for (auto& gameObject : m_gameObjects)
+    if (!m_player.getCollider())
+        return;
+
+    // One capsule kept across frames (so its contact pairs stay cached), moved to the player's stepped position before each test
+    if (!m_steppedCollider)
     {
-        if (gameObject -> m_collider && m_player.getCollider())
+        m_steppedCollider = Collider::createCapsuleManualSet(LibMath::Point3D(), LibMath::Point3D(), m_player.m_radius);
+        m_steppedCollider -> setLayer(LAYER_PLAYER);
+    }
+    Collider& steppedCollider = *m_steppedCollider;
+    CapsuleCollider* steppedCapsule = static_cast<CapsuleCollider*>(m_steppedCollider.get());
+
+    auto updateSteppedCapsule = [&]()
+    {
+        LibMath::Vector3 steppedPosition = m_player.getPosition();
+        steppedPosition += (m_player.getVelocity() * deltaTime);
+
+        LibMath::Point3D p1(steppedPosition.m_x, steppedPosition.m_y, steppedPosition.m_z);
+        LibMath::Point3D p2(steppedPosition.m_x, steppedPosition.m_y + m_player.m_height, steppedPosition.m_z);
+
+        steppedCapsule -> updateCapsule(p1, p2, m_player.m_radius);
+    };
+
+    // Remove the velocity component pushing into the contact
+    auto resolveContact = [&](const LibMath::Vector3& normal)
+    {
+        Vector3 velocity = m_player.getVelocity();
+        velocity.projectOnto(normal);
+        if (normal.dot(Vector3(0, 1, 0)) >= 0.9f)
+        {
+            m_player.m_grounded = true;
+        }
+        if (velocity.dot(normal) < 0)
         {
-            LibMath::Vector3 steppedPosition = m_player.getPosition();
-            steppedPosition += (m_player.getVelocity() * deltaTime);
+            m_player.AddVelocity(-velocity);
+        }
+    };
+
+    // Doors matching the phone colour are rejected by the broad-phase, before any narrow-phase work
+    QueryFilter solids;
+    solids.m_include = LAYER_SOLID;
+    solids.m_exclude = colorLayer(m_player.getPhone().getState());
+
+    // Static level: a few distance field samples along the capsule instead of one test per box
+    if (m_staticField.isBaked())
+    {
+        solids.m_include &= ~LAYER_OBSTACLE;
 
-            LibMath::Point3D p1(steppedPosition.m_x, steppedPosition.m_y, steppedPosition.m_z);
-            LibMath::Point3D p2(steppedPosition.m_x, steppedPosition.m_y + m_player.m_height, steppedPosition.m_z);
+        m_staticContacts.clear();
+        m_staticExact.clear();
+        updateSteppedCapsule();
+        m_staticField.queryCapsule(steppedCapsule -> getCapsule(), m_staticContacts, m_staticExact);
 
-            steppedCollider = Collider::createCapsuleManualSet(p1, p2, m_player.m_radius);
+        for (const auto& contact : m_staticContacts)
+        {
+            resolveContact(contact.m_normal);
+        }
 
-            if (gameObject -> m_collider -> checkCollision(*steppedCollider, collisionNormal))
+        // Thin features (stairs, ledges) fall back to the exact test against nearby boxes only
+        for (Collider* collider : m_staticExact)
+        {
+            updateSteppedCapsule();
+            if (m_contactCache.test(*collider, steppedCollider, collisionNormal))
             {
-                if (gameObject -> m_type == GameObjectType::DEATH_ZONE)
-                {
-                    resetGame();
-                }
-
-                if (gameObject -> m_type == GameObjectType::END_POINT)
-                {
-					winGame(); // Player reached the end point
-                }
-
-                // Disable Collider if Player has same ColorState as GameObject and is a Door
-                if (gameObject -> m_colorState == m_player.getPhone().getState() && gameObject -> m_type == GameObjectType::DOOR)
-                {
-					continue; // skip this collider
-                }
-                Vector3 velocity = m_player.getVelocity();
-                velocity.projectOnto(collisionNormal);
-                if (collisionNormal.dot(Vector3(0, 1, 0)) >= 0.9f)
-                {
-                    m_player.m_grounded = true;
-                }
-                if (velocity.dot(collisionNormal) < 0)
-                {
-                    m_player.AddVelocity(-velocity);
-                }
+                resolveContact(collisionNormal);
             }
         }
-	}
+    }
+
+    m_broadPhase.forEach(solids, [&](Collider& collider)
+    {
+        updateSteppedCapsule();
+
+        if (m_contactCache.test(collider, steppedCollider, collisionNormal))
+        {
+            resolveContact(collisionNormal);
+        }
+    });
 }
 
 void Application::updateMovingGameObjects(float deltaTime)
@@ -367,20 +511,11 @@ void Application::updateMovingGameObjects(float deltaTime)
     {
         if (gameObject -> m_type == GameObjectType::MOVING_OBJECT)
         {
-            // Remove old collider pointer from m_colliders
-            auto it = std::find(m_colliders.begin(), m_colliders.end(), gameObject -> m_collider.get());
-            if (it != m_colliders.end())
-                m_colliders.erase(it);
-
-            // Update transform (which updates the collider)
+            // Update transform (which updates the collider in place, so the broad-phase entry stays valid)
             gameObject -> updateTransform(deltaTime, LibMath::Matrix4::createTransform(
                 LibMath::Vector3(0, -1, -30),
                 LibMath::Radian(0),
 				LibMath::Vector3(1, 1, 1))); 
-
-            // Add new collider pointer to m_colliders
-            if (gameObject -> m_collider)
-                m_colliders.push_back(gameObject -> m_collider.get());
         }
     }
 }
@@ -412,6 +547,77 @@ void Application::processInput(float deltaTime)
         }
         m_escPressedLastFrame = true; // Mark that Escape was pressed this frame
     }
+
+    // F3 toggles the profiling overlay
+    bool f3Pressed = glfwGetKey(m_window, GLFW_KEY_F3) == GLFW_PRESS;
+    if (f3Pressed && !m_f3PressedLastFrame)
+    {
+        m_showProfiler = !m_showProfiler;
+    }
+    m_f3PressedLastFrame = f3Pressed;
+}
+
+// Profiling overlay content
+void Application::drawProfiler()
+{
+    m_uiManager.drawProfiler([this]()
+    {
+        const auto& frame = m_contactCache.getFrameStats();
+        const auto& total = m_contactCache.getTotalStats();
+        ImGui::Text("Contact cache: %zu pairs", m_contactCache.size());
+        ImGui::Text("  frame: %u hits / %u tests (%.0f%%)", frame.m_hits, frame.m_hits + frame.m_misses, frame.hitRate() * 100.0f);
+        ImGui::Text("  total: %u hits / %u tests (%.0f%%)", total.m_hits, total.m_hits + total.m_misses, total.hitRate() * 100.0f);
+        ImGui::Text("Static field: %zu boxes, %zu bricks (%zu KB)", m_staticField.getColliderCount(), m_staticField.getBrickCount(),
+            m_staticField.getMemoryUsage() / 1024);
+        ImGui::Text("Lights: %zu bytes in %zu uploads", m_lightBuffer.getUploadedBytes(), m_lightBuffer.getUploadCount());
+        ImGui::Text("Triangles: %zu drawn, %zu at full detail", m_drawnTriangles, m_fullDetailTriangles);
+        ImGui::Text("Draw calls: %zu for %zu meshes", m_meshBatcher.getDrawCount(), m_meshBatcher.getInstanceCount());
+        ImGui::Text("Texture binds: %zu, atlas: %zu textures on %d pages (%.1f MB)", m_textureBinds, m_textureAtlas.getEntryCount(),
+            m_textureAtlas.getPageCount(), m_textureAtlas.getGpuBytes() / (1024.0 * 1024.0));
+        ImGui::Text("Loader: %zu pending (%u workers)", m_loader.getPendingCount(), m_loader.getWorkerCount());
+        auto memoryLine = [](const char* label, const ResourceManager::MemoryStats& stats)
+        {
+            ImGui::Text("%s: %u (%u in use, %u evicted)  CPU %.1f MB  GPU %.1f MB", label, stats.m_count, stats.m_referenced,
+                stats.m_evicted, stats.m_cpuBytes / (1024.0 * 1024.0), stats.m_gpuBytes / (1024.0 * 1024.0));
+        };
+        memoryLine("Textures", m_resourceManager.getMemoryStats<Texture>());
+        memoryLine("Models", m_resourceManager.getMemoryStats<Model>());
+        ImGui::Text("Budget: %.1f / %.1f MB, %zu evictions", m_resourceManager.getMemoryStats().totalBytes() / (1024.0 * 1024.0),
+            m_resourceManager.getMemoryBudget() / (1024.0 * 1024.0), m_resourceManager.getEvictionCount());
+    });
+}
+
+// Write changed lights into the light buffer, then send the dirty ranges and bind it
+void Application::updateLightBuffer()
+{
+    m_lightBuffer.setCounts(
+        static_cast<int>(m_dirLights.size()),
+        static_cast<int>(m_pointLights.size()),
+        static_cast<int>(m_spotLights.size()));
+
+    int i = 0;
+    for (auto* light : m_dirLights)
+    {
+        if (light -> isDirty())
+            light -> writeTo(m_lightBuffer, i);
+        ++i;
+    }
+    i = 0;
+    for (auto* light : m_pointLights)
+    {
+        if (light -> isDirty())
+            light -> writeTo(m_lightBuffer, i);
+        ++i;
+    }
+    i = 0;
+    for (auto* light : m_spotLights)
+    {
+        if (light -> isDirty())
+            light -> writeTo(m_lightBuffer, i);
+        ++i;
+    }
+
+    m_lightBuffer.upload();
 }
 
 // Render the scene
@@ -420,70 +626,78 @@ void Application::render()
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    auto* shader = m_resourceManager.get<Shader>("LightShader");
+    auto* shader = m_resourceManager.get(m_lightShader);
     shader -> use();
 
-    GLuint pid = shader->getID();
-    static GLint locViewPos = glGetUniformLocation(pid, "uViewPos");
-    static GLint locMatDiffuse = glGetUniformLocation(pid, "uMatDiffuse");
-    static GLint locMatSpecular = glGetUniformLocation(pid, "uMatSpecular");
-    static GLint locMatShininess = glGetUniformLocation(pid, "uMatShininess");
-    static GLint locNumDir = glGetUniformLocation(pid, "numDir");
-    static GLint locNumPoint = glGetUniformLocation(pid, "numPoint");
-    static GLint locNumSpot = glGetUniformLocation(pid, "numSpot");
+    const LightShaderUniforms& uniforms = m_lightUniforms;
 
     // Camera pos
-    Vector3 camPos = m_camera.getPosition();
-    glUniform3fv(locViewPos, 1, &camPos.m_x);
+    shader -> set(uniforms.m_viewPos, m_camera.getPosition());
 
     // Material
-    glUniform4f(locMatDiffuse, 1, 1, 1, 1);
-    glUniform4f(locMatSpecular, 1, 1, 1, 1);
-    glUniform1f(locMatShininess, 64.0f);
+    shader -> set(uniforms.m_matDiffuse, Vector4(1, 1, 1, 1));
+    shader -> set(uniforms.m_matSpecular, Vector4(1, 1, 1, 1));
+    shader -> set(uniforms.m_matShininess, 64.0f);
 
-    // Upload light counts
-    glUniform1i(locNumDir, static_cast<int>(m_dirLights.size()));
-    glUniform1i(locNumPoint, static_cast<int>(m_pointLights.size()));
-    glUniform1i(locNumSpot, static_cast<int>(m_spotLights.size()));
-
-    // Upload each light
-    int i = 0;
-    for (auto* light : m_dirLights) light->uploadUniforms(*shader, i++);
-    i = 0;
-    for (auto* light : m_pointLights) light->uploadUniforms(*shader, i++);
-    i = 0;
-    for (auto* light : m_spotLights) light->uploadUniforms(*shader, i++);
+    // Lights (only the ones that changed since last frame reach the GPU)
+    updateLightBuffer();
 
     // draw meshes
     Matrix4 viewProj = m_camera.getProjectionMatrix() * m_camera.getViewMatrix();
     //drawSceneGraph(m_sceneRoot.get(), shader, viewProj);
-    std::vector<GameObject*> transparentList;
 
-    glDepthMask(GL_TRUE);              // enable depth writes
-    glDisable(GL_BLEND);
+    // LOD selection: pixels covered by one world unit at distance 1
+    const Vector3 cameraPosition = m_camera.getPosition();
+    const Vector3 cameraForward = m_camera.getForward();
+    const float projectionScale = m_camera.getProjectionMatrix().getData()[5] * 0.5f * static_cast<float>(m_height);
+    m_drawnTriangles = 0;
+    m_fullDetailTriangles = 0;
+    m_renderQueue.clear();
     for (auto& gameObject : m_gameObjects)
     {
-        if (gameObject -> m_mesh)
+        if (Mesh* mesh = gameObject -> m_mesh)
         {
-            if (gameObject -> m_type == GameObjectType::DOOR || gameObject -> m_type == GameObjectType::DEATH_ZONE)
-            {
-                transparentList.push_back(gameObject);
-            }
-            else
+            mesh -> selectLod(cameraPosition, projectionScale);
+            std::span<const Model::Lod> lods = mesh -> getModel() -> getLods();
+            if (!lods.empty())
             {
-                gameObject->m_mesh->draw(shader, viewProj);
+                m_drawnTriangles += lods[std::min(mesh -> getLod(), lods.size() - 1)].m_indexCount / 3;
+                m_fullDetailTriangles += lods[0].m_indexCount / 3;
             }
 
+            // Doors and death zones are see-through
+            const bool transparent = gameObject -> m_type == GameObjectType::DOOR || gameObject -> m_type == GameObjectType::DEATH_ZONE;
+            const float depth = (mesh -> getWorldCenter() - cameraPosition).dot(cameraForward);
+            m_renderQueue.submit(mesh, transparent ? RenderQueue::Pass::Transparent : RenderQueue::Pass::Opaque, m_lightShader.m_index, depth);
         }
-	}
-    
-    glDepthMask(GL_FALSE);             // **disable** depth writes
-    glEnable(GL_BLEND);
-    for (auto& gameObject : transparentList)
+    }
+
+    // Opaque: grouped by state (runs of one model and material become one instanced draw), front to back within a group.
+    // Transparent: back to front.
+    m_renderQueue.sort();
+
+    // The atlas stays bound for the whole pass, meshes only bind the textures too large for it
+    m_textureAtlas.bind(Mesh::k_atlasUnit);
+    Mesh::DrawState drawState;
+    m_meshBatcher.resetStats();
+
+    glDepthMask(GL_TRUE);              // enable depth writes
+    glDisable(GL_BLEND);
+    RenderQueue::Pass pass = RenderQueue::Pass::Opaque;
+    for (const RenderQueue::Item& item : m_renderQueue.getItems())
     {
-        gameObject->m_mesh->draw(shader, viewProj);;
+        if (item.m_pass != pass)
+        {
+            m_meshBatcher.flush(*shader, uniforms.m_mesh, viewProj, drawState);
+            pass = item.m_pass;
+            glDepthMask(GL_FALSE);     // **disable** depth writes
+            glEnable(GL_BLEND);
+        }
+        m_meshBatcher.add(item.m_mesh);
     }
+    m_meshBatcher.flush(*shader, uniforms.m_mesh, viewProj, drawState);
     glDepthMask(GL_TRUE);
+    m_textureBinds = drawState.m_bindCount;
 }
 void Application::winGame()
 {
@@ -494,6 +708,9 @@ void Application::winGame()
 // Shutdown the application
 void Application::shutdown()
 {
+    // Stop streaming before the resources and the GL context go away
+    m_loader.shutdown();
+
     // Delete dynamically allocated Light Instances
     for (auto* L : m_dirLights)
     {
@@ -512,6 +729,7 @@ void Application::shutdown()
         delete L;
     }
     m_spotLights.clear();
+    m_lightBuffer.destroy();
 
     // Delete dynamically allocated GameObject instances
     for (auto* go : m_gameObjects)
@@ -530,8 +748,9 @@ void Application::shutdown()
     }
     m_LevelMeshes.clear(); // Clear the multimap after deleting contents
 
-    // Clear the collider list (these are non-owning pointers, owned by GameObjects)
-    m_colliders.clear();
+    // Clear the broad-phase and triggers (non-owning pointers, owned by GameObjects)
+    m_broadPhase.clear();
+    m_triggers.clear();
 
 	// Shutdown ImGui
     ImGui_ImplOpenGL3_Shutdown();
@@ -560,7 +779,10 @@ void Application::resetGame()
         delete go; // Delete the GameObject instances
     }
     m_gameObjects.clear(); // Clear the vector itself
-    m_colliders.clear(); // Clear the vector of raw collider pointers
+    m_broadPhase.clear(); // Clear the broad-phase of raw collider pointers
+    m_triggers.clear();
+    m_contactCache.clear();
+    m_resetRequested = false;
 
     // Delete existing Mesh instances loaded by Mesh::LoadInstances ---
     for (auto& pair : m_LevelMeshes) // Iterate through the multimap
@@ -583,7 +805,7 @@ void Application::resetGame()
     m_player.setCamera(&m_camera); // Re-set camera for the new player instance
 
     // Re-load mesh instances (and then re-create game objects)
-    if (!Mesh::loadInstances("../../Assets/Levels/LevelTest.txt", m_LevelMeshes, m_resourceManager))
+    if (!Mesh::loadInstances(m_levelData, m_LevelMeshes, m_resourceManager, &m_loader))
     {
         // Handle error: if reloading fails, your game is in a bad state.
         std::cerr << "CRITICAL ERROR: Failed to reload mesh instances during game reset!\n";
@@ -0,0 +1,55 @@
+#include "Physics/BroadPhase.h"
+#include "Physics/Collider.h"
+#include <algorithm>
+
+namespace Physics
+{
+    // Register a collider in the bucket matching its layer
+    void BroadPhase::add(Collider* collider)
+    {
+        if (!collider)
+            return;
+
+        uint32_t layer = collider -> getLayer();
+        for (Bucket& bucket : m_buckets)
+        {
+            if (bucket.m_layer == layer)
+            {
+                bucket.m_colliders.push_back(collider);
+                return;
+            }
+        }
+
+        Bucket bucket;
+        bucket.m_layer = layer;
+        bucket.m_colliders.push_back(collider);
+        m_buckets.push_back(std::move(bucket));
+    }
+
+    // Unregister a collider (no-op if it was never added)
+    void BroadPhase::remove(Collider* collider)
+    {
+        for (Bucket& bucket : m_buckets)
+        {
+            auto it = std::find(bucket.m_colliders.begin(), bucket.m_colliders.end(), collider);
+            if (it != bucket.m_colliders.end())
+            {
+                bucket.m_colliders.erase(it);
+                return;
+            }
+        }
+    }
+
+    void BroadPhase::clear()
+    {
+        m_buckets.clear();
+    }
+
+    size_t BroadPhase::size() const
+    {
+        size_t count = 0;
+        for (const Bucket& bucket : m_buckets)
+            count += bucket.m_colliders.size();
+        return count;
+    }
+}
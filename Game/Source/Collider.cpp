@@ -5,24 +5,36 @@
 #include <vector>
 #include "LibMath/Geometry3D.h"
 
-// Helper to extract positions from mesh
+// Helper to extract positions from mesh: every vertex, or the collision proxy of a model
+// whose geometry only lives on the GPU
 static std::vector<LibMath::Vector3> GetTransformedMeshPositions(Mesh* mesh)
 {
     std::vector<LibMath::Vector3> positions;
     if (mesh && mesh->getModel())
     {
-        const LibMath::Matrix4& modelMatrix = mesh -> getModelMatrix();
-        for (const auto& v : mesh->getModel() -> getVertices())
+        const float* m = mesh -> getModelMatrix().getData();
+        auto transform = [&](const LibMath::Vector3& pos)
         {
-            // Transform the position by the model matrix
-            LibMath::Vector3 pos = v.m_position;
             // Homogeneous transform
             float x = pos.m_x, y = pos.m_y, z = pos.m_z;
-            const float* m = modelMatrix.getData();
             float tx = m[0] * x + m[4] * y + m[8] * z + m[12];
             float ty = m[1] * x + m[5] * y + m[9] * z + m[13];
             float tz = m[2] * x + m[6] * y + m[10] * z + m[14];
             positions.emplace_back(tx, ty, tz);
+        };
+
+        const Model* model = mesh -> getModel();
+        if (model -> isGeometryResident())
+        {
+            positions.reserve(model -> getVertices().size());
+            for (const auto& v : model -> getVertices())
+                transform(v.m_position);
+        }
+        else
+        {
+            positions.reserve(model -> getCollisionProxy().getPositions().size());
+            for (const auto& p : model -> getCollisionProxy().getPositions())
+                transform(p);
         }
     }
     return positions;
@@ -36,7 +48,8 @@ namespace Physics
     Collider::Collider(ColliderType type)
         : m_type(type)
     {
-        
+        static uint32_t s_nextId = 1;
+        m_id = s_nextId++;
     }
 
     // Returns the type of the collider.
@@ -98,6 +111,10 @@ namespace Physics
     // Static Factory Method: Creates a BoxCollider from a Mesh.
     std::unique_ptr<BoxCollider> BoxCollider::createFromMesh(Mesh* mesh)
     {
+        // Compiled levels carry the bounds, no need to transform every vertex
+        if (mesh && mesh -> hasWorldBounds())
+            return std::make_unique<BoxCollider>(mesh -> getWorldBounds());
+
         auto positions = GetTransformedMeshPositions(mesh);
         if (positions.empty()) return nullptr;
 
@@ -355,6 +372,14 @@ namespace Physics
         m_sphere = LibMath::Sphere3D(LibMath::Point3D(center.m_x, center.m_y, center.m_z), radius);
     }
 
+    LibMath::Prism3DAABB SphereCollider::getBounds() const
+    {
+        LibMath::Point3D c = m_sphere.getCenter();
+        float r = m_sphere.getRadius();
+        return LibMath::Prism3DAABB(LibMath::Point3D(c.getX() - r, c.getY() - r, c.getZ() - r),
+            LibMath::Point3D(c.getX() + r, c.getY() + r, c.getZ() + r));
+    }
+
     // --- CapsuleCollider Implementation ---
 
     // Constructor: Initializes the base Collider part and its own Capsule.
@@ -520,6 +545,16 @@ namespace Physics
 		m_capsule = capsule;
     }
 
+    LibMath::Prism3DAABB CapsuleCollider::getBounds() const
+    {
+        LibMath::Point3D a = m_capsule.getStart();
+        LibMath::Point3D b = m_capsule.getEnd();
+        float r = m_capsule.getRadius();
+        return LibMath::Prism3DAABB(
+            LibMath::Point3D(std::min(a.getX(), b.getX()) - r, std::min(a.getY(), b.getY()) - r, std::min(a.getZ(), b.getZ()) - r),
+            LibMath::Point3D(std::max(a.getX(), b.getX()) + r, std::max(a.getY(), b.getY()) + r, std::max(a.getZ(), b.getZ()) + r));
+    }
+
     void CapsuleCollider::updateCapsule(const LibMath::Point3D& p1, const LibMath::Point3D& p2, float r)
     {
 		m_capsule = LibMath::Capsule3D(p1, p2, r);
@@ -0,0 +1,135 @@
+#include "Physics/ContactCache.h"
+#include "Physics/Collider.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Physics
+{
+    // Relative motion below this keeps a resting contact
+    static constexpr float k_restingMotion = 1e-4f;
+
+    // Half extents and centre of a collider's bounds
+    static void boundsOf(const Collider& collider, LibMath::Vector3& outCenter, LibMath::Vector3& outHalf)
+    {
+        LibMath::Prism3DAABB bounds = collider.getBounds();
+        LibMath::Point3D min = bounds.getMin();
+        LibMath::Point3D max = bounds.getMax();
+        outCenter = LibMath::Vector3((min.getX() + max.getX()) * 0.5f, (min.getY() + max.getY()) * 0.5f, (min.getZ() + max.getZ()) * 0.5f);
+        outHalf = LibMath::Vector3((max.getX() - min.getX()) * 0.5f, (max.getY() - min.getY()) * 0.5f, (max.getZ() - min.getZ()) * 0.5f);
+    }
+
+    // Pairs are ordered: (a, b) and (b, a) are separate entries, as the normal depends on the order
+    uint64_t ContactCache::pairKey(const Collider& a, const Collider& b)
+    {
+        return (static_cast<uint64_t>(a.getId()) << 32) | b.getId();
+    }
+
+    bool ContactCache::test(const Collider& a, const Collider& b, LibMath::Vector3& outNormal)
+    {
+        LibMath::Vector3 centerA, halfA, centerB, halfB;
+        boundsOf(a, centerA, halfA);
+        boundsOf(b, centerB, halfB);
+
+        LibMath::Vector3 offset = centerB - centerA;
+        LibMath::Vector3 extents = halfA + halfB;
+
+        auto [it, inserted] = m_entries.try_emplace(pairKey(a, b));
+        Entry& entry = it -> second;
+
+        if (!inserted)
+        {
+            // Bound on how much the gap can have shrunk (or the contact changed) since the last test
+            LibMath::Vector3 motion = offset - entry.m_offset;
+            float dx = std::abs(motion.m_x) + std::abs(extents.m_x - entry.m_extents.m_x);
+            float dy = std::abs(motion.m_y) + std::abs(extents.m_y - entry.m_extents.m_y);
+            float dz = std::abs(motion.m_z) + std::abs(extents.m_z - entry.m_extents.m_z);
+            float relativeMotion = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+            bool reuse = entry.m_touching ? relativeMotion <= k_restingMotion : relativeMotion < entry.m_separation;
+            if (reuse)
+            {
+                entry.m_frame = m_frame;
+                ++m_frameStats.m_hits;
+                ++m_totalStats.m_hits;
+
+                if (entry.m_touching)
+                    outNormal = entry.m_normal;
+                return entry.m_touching;
+            }
+
+            if (!entry.m_touching)
+            {
+                // Bounds still apart along the last separating axis: so are the shapes, and that gap is the new bound
+                LibMath::Vector3 axisExtents(std::abs(entry.m_axis.m_x) * extents.m_x, std::abs(entry.m_axis.m_y) * extents.m_y,
+                                             std::abs(entry.m_axis.m_z) * extents.m_z);
+                float gap = offset.dot(entry.m_axis) - (axisExtents.m_x + axisExtents.m_y + axisExtents.m_z);
+                if (gap > 0.0f)
+                {
+                    entry.m_offset = offset;
+                    entry.m_extents = extents;
+                    entry.m_separation = gap;
+                    entry.m_frame = m_frame;
+                    ++m_frameStats.m_hits;
+                    ++m_totalStats.m_hits;
+                    return false;
+                }
+            }
+        }
+
+        ++m_frameStats.m_misses;
+        ++m_totalStats.m_misses;
+
+        bool touching = a.checkCollision(b, outNormal);
+
+        entry.m_offset = offset;
+        entry.m_extents = extents;
+        entry.m_frame = m_frame;
+        entry.m_touching = touching;
+
+        // Per-axis gap between the bounds (negative when they overlap)
+        const float gap[3] = {
+            std::abs(offset.m_x) - extents.m_x,
+            std::abs(offset.m_y) - extents.m_y,
+            std::abs(offset.m_z) - extents.m_z
+        };
+        int axis = static_cast<int>(std::max_element(gap, gap + 3) - gap);
+        const float direction[3] = { offset.m_x, offset.m_y, offset.m_z };
+        float sign = direction[axis] < 0.0f ? -1.0f : 1.0f;
+
+        if (touching)
+        {
+            entry.m_normal = outNormal;
+            entry.m_separation = 0.0f;
+        }
+        else
+        {
+            // The largest per-axis gap between the bounds is a lower bound of the distance between the shapes
+            entry.m_axis = LibMath::Vector3(axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f);
+            entry.m_separation = std::max(0.0f, gap[axis]);
+        }
+
+        return touching;
+    }
+
+    void ContactCache::beginFrame()
+    {
+        // Pairs the broad-phase stopped reporting are stale
+        for (auto it = m_entries.begin(); it != m_entries.end(); )
+        {
+            if (it -> second.m_frame != m_frame)
+                it = m_entries.erase(it);
+            else
+                ++it;
+        }
+
+        ++m_frame;
+        m_frameStats = Stats();
+    }
+
+    void ContactCache::clear()
+    {
+        m_entries.clear();
+        m_frameStats = Stats();
+        m_totalStats = Stats();
+    }
+}
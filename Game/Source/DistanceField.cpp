@@ -0,0 +1,435 @@
+#include "Physics/DistanceField.h"
+#include "Physics/Collider.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+    struct SourceBox
+    {
+        LibMath::Vector3    m_center;
+        LibMath::Vector3    m_halfExtent;
+        Physics::Collider*  m_collider = nullptr;
+        bool                m_thin = false;
+    };
+
+    // Signed distance from a point to a box (negative inside)
+    float boxDistance(const LibMath::Vector3& point, const SourceBox& box)
+    {
+        float qx = std::fabs(point.m_x - box.m_center.m_x) - box.m_halfExtent.m_x;
+        float qy = std::fabs(point.m_y - box.m_center.m_y) - box.m_halfExtent.m_y;
+        float qz = std::fabs(point.m_z - box.m_center.m_z) - box.m_halfExtent.m_z;
+
+        float ox = std::max(qx, 0.0f);
+        float oy = std::max(qy, 0.0f);
+        float oz = std::max(qz, 0.0f);
+        float outside = std::sqrt(ox * ox + oy * oy + oz * oz);
+        float inside = std::min(std::max(qx, std::max(qy, qz)), 0.0f);
+        return outside + inside;
+    }
+
+    bool samePoint(const LibMath::Point3D& a, const LibMath::Point3D& b)
+    {
+        return a.getX() == b.getX() && a.getY() == b.getY() && a.getZ() == b.getZ();
+    }
+}
+
+namespace Physics
+{
+    void DistanceField::clear()
+    {
+        m_dims[0] = m_dims[1] = m_dims[2] = 0;
+        m_brickIndex.clear();
+        m_coarse.clear();
+        m_samples.clear();
+        m_nearest.clear();
+        m_colliders.clear();
+        m_colliderBounds.clear();
+        m_brickThin.clear();
+        m_exactStart.clear();
+        m_exactColliders.clear();
+    }
+
+    void DistanceField::bake(const std::vector<BoxCollider*>& boxes, const Settings& settings)
+    {
+        clear();
+        m_settings = settings;
+        m_settings.m_brickSize = std::max(1, m_settings.m_brickSize);
+        m_settings.m_bandWidth = std::max(m_settings.m_bandWidth, 2.0f * m_settings.m_voxelSize);
+
+        const int   brickSize = m_settings.m_brickSize;
+        const int   stride = brickSize + 1;
+        const float voxel = m_settings.m_voxelSize;
+        const float band = m_settings.m_bandWidth;
+
+        // 1) Gather the source boxes and the level bounds
+        std::vector<SourceBox> sources;
+        sources.reserve(boxes.size());
+
+        const float inf = std::numeric_limits<float>::max();
+        LibMath::Vector3 lo(inf, inf, inf);
+        LibMath::Vector3 hi(-inf, -inf, -inf);
+
+        for (BoxCollider* box : boxes)
+        {
+            if (!box)
+                continue;
+
+            const LibMath::Prism3DAABB& aabb = box -> getAABB();
+            LibMath::Point3D min = aabb.getMin();
+            LibMath::Point3D max = aabb.getMax();
+
+            SourceBox source;
+            source.m_center = LibMath::Vector3((min.getX() + max.getX()) * 0.5f, (min.getY() + max.getY()) * 0.5f, (min.getZ() + max.getZ()) * 0.5f);
+            source.m_halfExtent = LibMath::Vector3((max.getX() - min.getX()) * 0.5f, (max.getY() - min.getY()) * 0.5f, (max.getZ() - min.getZ()) * 0.5f);
+            source.m_collider = box;
+
+            // Features thinner than two voxels are lost by trilinear sampling
+            float thinnest = std::min(source.m_halfExtent.m_x, std::min(source.m_halfExtent.m_y, source.m_halfExtent.m_z)) * 2.0f;
+            source.m_thin = thinnest < 2.0f * voxel;
+
+            lo = LibMath::Vector3(std::min(lo.m_x, min.getX()), std::min(lo.m_y, min.getY()), std::min(lo.m_z, min.getZ()));
+            hi = LibMath::Vector3(std::max(hi.m_x, max.getX()), std::max(hi.m_y, max.getY()), std::max(hi.m_z, max.getZ()));
+
+            sources.push_back(source);
+        }
+
+        if (sources.empty())
+            return;
+
+        // Nearest-collider ids are stored on 16 bits
+        if (sources.size() > 0xFFFF)
+        {
+            std::cerr << "DistanceField::bake: too many colliders (" << sources.size() << "), field not baked\n";
+            return;
+        }
+
+        for (const SourceBox& source : sources)
+        {
+            m_colliders.push_back(source.m_collider);
+            m_colliderBounds.push_back(source.m_collider -> getBounds());
+        }
+
+        // 2) Brick grid covering the bounds plus the band
+        m_brickWorldSize = voxel * brickSize;
+        m_origin = lo - LibMath::Vector3(band);
+        LibMath::Vector3 size = (hi + LibMath::Vector3(band)) - m_origin;
+        m_dims[0] = std::max(1, static_cast<int>(std::ceil(size.m_x / m_brickWorldSize)));
+        m_dims[1] = std::max(1, static_cast<int>(std::ceil(size.m_y / m_brickWorldSize)));
+        m_dims[2] = std::max(1, static_cast<int>(std::ceil(size.m_z / m_brickWorldSize)));
+
+        const size_t cellCount = size_t(m_dims[0]) * m_dims[1] * m_dims[2];
+        m_brickIndex.assign(cellCount, -1);
+        m_coarse.assign(cellCount, band);
+        m_quantScale = band / 32767.0f;
+        m_exactStart.push_back(0);
+
+        const float halfDiagonal = m_brickWorldSize * 0.5f * std::sqrt(3.0f);
+        std::vector<int> candidates;
+
+        // 3) Store samples only for bricks within reach of a surface
+        for (int bz = 0; bz < m_dims[2]; ++bz)
+        {
+            for (int by = 0; by < m_dims[1]; ++by)
+            {
+                for (int bx = 0; bx < m_dims[0]; ++bx)
+                {
+                    const size_t cell = (size_t(bz) * m_dims[1] + by) * m_dims[0] + bx;
+                    LibMath::Vector3 brickMin = m_origin + LibMath::Vector3(bx * m_brickWorldSize, by * m_brickWorldSize, bz * m_brickWorldSize);
+                    LibMath::Vector3 center = brickMin + LibMath::Vector3(m_brickWorldSize * 0.5f);
+
+                    candidates.clear();
+                    float nearest = inf;
+                    for (int i = 0; i < int(sources.size()); ++i)
+                    {
+                        float d = boxDistance(center, sources[i]);
+                        nearest = std::min(nearest, d);
+                        if (d <= halfDiagonal + band)
+                            candidates.push_back(i);
+                    }
+
+                    if (candidates.empty())
+                    {
+                        // Every point of this brick is at least this far from the geometry
+                        m_coarse[cell] = nearest - halfDiagonal;
+                        continue;
+                    }
+
+                    const int slot = int(m_brickThin.size());
+                    m_brickIndex[cell] = slot;
+                    m_coarse[cell] = nearest - halfDiagonal;
+
+                    size_t base = m_samples.size();
+                    m_samples.resize(base + size_t(stride) * stride * stride);
+                    m_nearest.resize(m_samples.size());
+
+                    bool thin = false;
+                    for (int candidate : candidates)
+                        thin = thin || sources[candidate].m_thin;
+
+                    for (int z = 0; z < stride; ++z)
+                    {
+                        for (int y = 0; y < stride; ++y)
+                        {
+                            for (int x = 0; x < stride; ++x)
+                            {
+                                LibMath::Vector3 p = brickMin + LibMath::Vector3(x * voxel, y * voxel, z * voxel);
+                                float d = inf;
+                                int nearestSource = candidates[0];
+                                for (int candidate : candidates)
+                                {
+                                    float candidateDistance = boxDistance(p, sources[candidate]);
+                                    if (candidateDistance < d)
+                                    {
+                                        d = candidateDistance;
+                                        nearestSource = candidate;
+                                    }
+                                }
+
+                                d = std::clamp(d, -band, band);
+                                size_t index = base + (size_t(z) * stride + y) * stride + x;
+                                m_samples[index] = static_cast<int16_t>(std::lround(d / m_quantScale));
+                                m_nearest[index] = static_cast<uint16_t>(nearestSource);
+                            }
+                        }
+                    }
+
+                    m_brickThin.push_back(thin ? 1 : 0);
+                    if (thin)
+                    {
+                        for (int candidate : candidates)
+                            m_exactColliders.push_back(static_cast<uint16_t>(candidate));
+                    }
+                    m_exactStart.push_back(uint32_t(m_exactColliders.size()));
+                }
+            }
+        }
+    }
+
+    // Returns the brick slot containing the point, -1 for an unstored cell, -2 outside the grid
+    int DistanceField::brickAt(const LibMath::Vector3& point, int& outCell) const
+    {
+        LibMath::Vector3 local = (point - m_origin) * (1.0f / m_brickWorldSize);
+        int bx = static_cast<int>(std::floor(local.m_x));
+        int by = static_cast<int>(std::floor(local.m_y));
+        int bz = static_cast<int>(std::floor(local.m_z));
+
+        if (bx < 0 || by < 0 || bz < 0 || bx >= m_dims[0] || by >= m_dims[1] || bz >= m_dims[2])
+        {
+            outCell = -1;
+            return -2;
+        }
+
+        outCell = (bz * m_dims[1] + by) * m_dims[0] + bx;
+        return m_brickIndex[outCell];
+    }
+
+    float DistanceField::sample(const LibMath::Vector3& point) const
+    {
+        LibMath::Vector3 gradient;
+        return sample(point, gradient);
+    }
+
+    float DistanceField::sample(const LibMath::Vector3& point, LibMath::Vector3& outGradient) const
+    {
+        outGradient = LibMath::Vector3::zero();
+        if (!isBaked())
+            return m_settings.m_bandWidth;
+
+        int cell = -1;
+        int brick = brickAt(point, cell);
+        if (brick == -2)
+            return m_settings.m_bandWidth;
+        if (brick < 0)
+            return m_coarse[cell];
+
+        return interpolate(brick, cell, point, outGradient, nullptr);
+    }
+
+    // Trilinear sample inside a stored brick; optionally returns the nearest collider of the 8 corners
+    float DistanceField::interpolate(int brick, int cell, const LibMath::Vector3& point, LibMath::Vector3& outGradient, uint16_t* outNearest) const
+    {
+        // Voxel coordinates inside the brick, in [0, brickSize]
+        const int   brickSize = m_settings.m_brickSize;
+        const int   stride = brickSize + 1;
+        const float voxel = m_settings.m_voxelSize;
+        LibMath::Vector3 local = (point - m_origin) * (1.0f / voxel);
+        int bx = cell % m_dims[0];
+        int by = (cell / m_dims[0]) % m_dims[1];
+        int bz = cell / (m_dims[0] * m_dims[1]);
+        float fx = std::clamp(local.m_x - bx * brickSize, 0.0f, float(brickSize));
+        float fy = std::clamp(local.m_y - by * brickSize, 0.0f, float(brickSize));
+        float fz = std::clamp(local.m_z - bz * brickSize, 0.0f, float(brickSize));
+
+        int ix = std::min(int(fx), brickSize - 1);
+        int iy = std::min(int(fy), brickSize - 1);
+        int iz = std::min(int(fz), brickSize - 1);
+        float tx = fx - ix;
+        float ty = fy - iy;
+        float tz = fz - iz;
+
+        // The 8 corner texels, in x, y, z bit order
+        size_t base = size_t(brick) * stride * stride * stride + (size_t(iz) * stride + iy) * stride + ix;
+        const size_t offsets[8] = {
+            0, 1, size_t(stride), size_t(stride) + 1,
+            size_t(stride) * stride, size_t(stride) * stride + 1, size_t(stride) * stride + stride, size_t(stride) * stride + stride + 1
+        };
+
+        float c[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            c[i] = m_samples[base + offsets[i]] * m_quantScale;
+            if (outNearest)
+                outNearest[i] = m_nearest[base + offsets[i]];
+        }
+
+        // Trilinear interpolation
+        float c00 = c[0] + (c[1] - c[0]) * tx;
+        float c10 = c[2] + (c[3] - c[2]) * tx;
+        float c01 = c[4] + (c[5] - c[4]) * tx;
+        float c11 = c[6] + (c[7] - c[6]) * tx;
+        float c0 = c00 + (c10 - c00) * ty;
+        float c1 = c01 + (c11 - c01) * ty;
+
+        // Analytic gradient of the trilinear interpolant
+        float dx = ((c[1] - c[0]) * (1 - ty) * (1 - tz) + (c[3] - c[2]) * ty * (1 - tz)
+                  + (c[5] - c[4]) * (1 - ty) * tz + (c[7] - c[6]) * ty * tz) / voxel;
+        float dy = ((c10 - c00) * (1 - tz) + (c11 - c01) * tz) / voxel;
+        float dz = (c1 - c0) / voxel;
+        outGradient = LibMath::Vector3(dx, dy, dz);
+
+        return c0 + (c1 - c0) * tz;
+    }
+
+    bool DistanceField::rebind(const std::vector<BoxCollider*>& boxes)
+    {
+        if (!isBaked())
+            return false;
+
+        std::vector<Collider*> colliders;
+        colliders.reserve(m_colliders.size());
+        for (BoxCollider* box : boxes)
+        {
+            if (!box)
+                continue;
+            // Same order and same bounds as when baked, or the samples no longer describe these boxes
+            const size_t index = colliders.size();
+            if (index >= m_colliderBounds.size())
+                return false;
+            const LibMath::Prism3DAABB bounds = box -> getBounds();
+            const LibMath::Prism3DAABB& baked = m_colliderBounds[index];
+            if (!samePoint(bounds.getMin(), baked.getMin()) || !samePoint(bounds.getMax(), baked.getMax()))
+                return false;
+            colliders.push_back(box);
+        }
+        if (colliders.size() != m_colliders.size())
+            return false;
+
+        m_colliders.swap(colliders);
+        return true;
+    }
+
+    void DistanceField::addExact(Collider* collider, std::vector<Collider*>& outExact) const
+    {
+        if (std::find(outExact.begin(), outExact.end(), collider) == outExact.end())
+            outExact.push_back(collider);
+    }
+
+    void DistanceField::queryCapsule(const LibMath::Capsule3D& capsule, std::vector<Contact>& outContacts, std::vector<Collider*>& outExact) const
+    {
+        if (!isBaked())
+            return;
+
+        LibMath::Point3D a = capsule.getStart();
+        LibMath::Point3D b = capsule.getEnd();
+        float radius = capsule.getRadius();
+
+        LibMath::Vector3 start(a.getX(), a.getY(), a.getZ());
+        LibMath::Vector3 segment = LibMath::Vector3(b.getX(), b.getY(), b.getZ()) - start;
+
+        // Samples half a radius (or half a voxel, if smaller) apart, so no surface slips between two of them
+        float spacing = (radius > 0.0f ? std::min(radius, m_settings.m_voxelSize) : m_settings.m_voxelSize) * 0.5f;
+        int sampleCount = std::max(2, static_cast<int>(std::ceil(segment.magnitude() / spacing)) + 1);
+
+        for (int s = 0; s < sampleCount; ++s)
+        {
+            LibMath::Vector3 point = start + segment * (float(s) / float(sampleCount - 1));
+
+            int cell = -1;
+            int brick = brickAt(point, cell);
+            if (brick < 0)
+                continue; // Unstored or outside: farther than the band from any surface
+
+            if (m_brickThin[brick])
+            {
+                // Thin feature nearby: hand its colliders to the exact narrow phase
+                for (uint32_t i = m_exactStart[brick]; i < m_exactStart[brick + 1]; ++i)
+                    addExact(m_colliders[m_exactColliders[i]], outExact);
+                continue;
+            }
+
+            LibMath::Vector3 gradient;
+            uint16_t nearest[8];
+            float distance = interpolate(brick, cell, point, gradient, nearest);
+            if (distance >= radius)
+                continue;
+
+            // Near a crease the interpolated gradient blends two surfaces: test those colliders exactly
+            bool crease = false;
+            for (int i = 1; i < 8; ++i)
+                crease = crease || nearest[i] != nearest[0];
+
+            if (crease)
+            {
+                for (int i = 0; i < 8; ++i)
+                    addExact(m_colliders[nearest[i]], outExact);
+                continue;
+            }
+
+            LibMath::Vector3 normal = gradient;
+            if (normal.magnitudeSquared() < 1e-12f)
+                normal = LibMath::Vector3::up();
+            else
+                normal.normalize();
+
+            // Merge with a contact facing the same way, keeping the deepest
+            float depth = radius - distance;
+            bool merged = false;
+            for (Contact& contact : outContacts)
+            {
+                if (contact.m_normal.dot(normal) > 0.95f)
+                {
+                    if (depth > contact.m_depth)
+                    {
+                        contact.m_depth = depth;
+                        contact.m_normal = normal;
+                    }
+                    merged = true;
+                    break;
+                }
+            }
+
+            if (!merged)
+            {
+                Contact contact;
+                contact.m_normal = normal;
+                contact.m_depth = depth;
+                outContacts.push_back(contact);
+            }
+        }
+    }
+
+    size_t DistanceField::getMemoryUsage() const
+    {
+        return m_samples.size() * sizeof(int16_t)
+            + m_nearest.size() * sizeof(uint16_t)
+            + m_colliders.size() * (sizeof(Collider*) + sizeof(LibMath::Prism3DAABB))
+            + m_brickIndex.size() * sizeof(int32_t)
+            + m_coarse.size() * sizeof(float)
+            + m_brickThin.size() * sizeof(uint8_t)
+            + m_exactStart.size() * sizeof(uint32_t)
+            + m_exactColliders.size() * sizeof(uint16_t);
+    }
+}
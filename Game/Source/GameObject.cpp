@@ -1,43 +1,50 @@
 #include "GameObject.h"
 #include "LibMath/Arithmetic.h"
+#include <iterator>
 
 void GameObject::setMeshTexture()
 {
 	if (m_mesh)
 	{
-		switch (m_colorState)
-	    {
-			case ColorState::E_INACTIVE:
-			{
-				Texture* textureInactive = m_resourceManager.get<Texture>("gray_color");
-				m_mesh -> setTexture(textureInactive);
-				break;
-			}
-			case ColorState::E_RED:
-			{
-				Texture* textureRed = m_resourceManager.get<Texture>("red_color");
-				m_mesh -> setTexture(textureRed);
-				break;
-			}
-			case ColorState::E_BLUE:
-			{
-				Texture* textureBlue = m_resourceManager.get<Texture>("blue_color");
-				m_mesh -> setTexture(textureBlue);
-				break;
-			}
-			case ColorState::E_YELLOW:
-			{
-				Texture* textureYellow = m_resourceManager.get<Texture>("yellow_color");
-				m_mesh -> setTexture(textureYellow);
-				break;
-			}
-			default:
-			{
-				Texture* textureDefault = m_resourceManager.get<Texture>("gray_color");
-				m_mesh -> setTexture(textureDefault);
-				break;
-			}
+		// Material per ColorState, in enum order
+		static const char* const k_colorMaterials[] = { "gray_color", "red_color", "blue_color", "yellow_color" };
+
+		size_t index = static_cast<size_t>(m_colorState);
+		if (index >= std::size(k_colorMaterials))
+			index = 0;
+
+		// Resolved once, and again only if the material was replaced since
+		Handle<MaterialInstance>& handle = m_colorMaterials[index];
+		MaterialInstance* material = m_resourceManager.get(handle);
+		if (!material)
+		{
+			handle = m_resourceManager.find<MaterialInstance>(k_colorMaterials[index]);
+			material = m_resourceManager.get(handle);
 		}
+		m_mesh -> setMaterial(material);
+	}
+}
+
+// Map the object type (and, for doors, the colour) onto collision layer bits
+uint32_t GameObject::getCollisionLayer() const
+{
+	switch (m_type)
+	{
+		case GameObjectType::OBSTACLE:
+			return Physics::LAYER_OBSTACLE;
+		case GameObjectType::DOOR:
+			// Doors are the only objects the phone colour lets the player walk through
+			return Physics::LAYER_DOOR | Physics::colorLayer(m_colorState);
+		case GameObjectType::BUTTON:
+			return Physics::LAYER_BUTTON;
+		case GameObjectType::MOVING_OBJECT:
+			return Physics::LAYER_MOVING_OBJECT;
+		case GameObjectType::END_POINT:
+			return Physics::LAYER_END_POINT;
+		case GameObjectType::DEATH_ZONE:
+			return Physics::LAYER_DEATH_ZONE;
+		default:
+			return Physics::LAYER_OBSTACLE;
 	}
 }
 
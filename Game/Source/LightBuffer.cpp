@@ -0,0 +1,154 @@
+#include "LightBuffer.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// The mirror is copied to the GPU as raw bytes, so it must match the std140 layout exactly
+static_assert(sizeof(LibMath::Vector3) == 12 && sizeof(LibMath::Vector4) == 16, "LightBuffer: vectors must be tightly packed floats");
+static_assert(sizeof(LightBuffer::DirLight) == 64, "LightBuffer: DirLight does not match std140");
+static_assert(sizeof(LightBuffer::PointLight) == 80, "LightBuffer: PointLight does not match std140");
+static_assert(sizeof(LightBuffer::SpotLight) == 96, "LightBuffer: SpotLight does not match std140");
+static_assert(offsetof(LightBuffer::SpotLight, m_ambient) == 32, "LightBuffer: SpotLight does not match std140");
+
+namespace
+{
+    // Dirty ranges closer than this are sent in one glBufferSubData call
+    constexpr size_t k_mergeGap = 64;
+}
+
+LightBuffer::LightBuffer() = default;
+
+// Create the buffer holding the whole block and fill it from the mirror
+bool LightBuffer::init()
+{
+    destroy();
+
+    glGenBuffers(1, &m_buffer);
+    if (m_buffer == 0)
+    {
+        std::cerr << "LightBuffer: failed to create the uniform buffer\n";
+        return false;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &m_block, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, k_bindingPoint, m_buffer);
+
+    m_dirty.clear();
+    m_uploadedBytes = sizeof(Block);
+    m_uploadCount = 1;
+    return true;
+}
+
+void LightBuffer::destroy()
+{
+    if (m_buffer != 0)
+    {
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+    m_dirty.clear();
+}
+
+// The binding is program state, so it must be set again whenever the program is relinked
+bool LightBuffer::bindBlock(const Shader& shader)
+{
+    GLuint index = glGetUniformBlockIndex(shader.getID(), k_blockName);
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cerr << "LightBuffer: program " << shader.getID() << " has no '" << k_blockName << "' block\n";
+        return false;
+    }
+
+    GLint blockSize = 0;
+    glGetActiveUniformBlockiv(shader.getID(), index, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+    if (static_cast<size_t>(blockSize) != sizeof(Block))
+    {
+        std::cerr << "LightBuffer: '" << k_blockName << "' is " << blockSize << " bytes, expected " << sizeof(Block) << "\n";
+        return false;
+    }
+
+    glUniformBlockBinding(shader.getID(), index, k_bindingPoint);
+    return true;
+}
+
+void LightBuffer::setCounts(int dirCount, int pointCount, int spotCount)
+{
+    int32_t counts[3] = {
+        std::clamp(dirCount, 0, k_maxDir),
+        std::clamp(pointCount, 0, k_maxPoint),
+        std::clamp(spotCount, 0, k_maxSpot)
+    };
+    write(offsetof(Block, m_numDir), counts, sizeof(counts));
+}
+
+void LightBuffer::setDirLight(int index, const DirLight& light)
+{
+    if (index >= 0 && index < k_maxDir)
+        write(offsetof(Block, m_dirLights) + sizeof(DirLight) * index, &light, sizeof(DirLight));
+}
+
+void LightBuffer::setPointLight(int index, const PointLight& light)
+{
+    if (index >= 0 && index < k_maxPoint)
+        write(offsetof(Block, m_pointLights) + sizeof(PointLight) * index, &light, sizeof(PointLight));
+}
+
+void LightBuffer::setSpotLight(int index, const SpotLight& light)
+{
+    if (index >= 0 && index < k_maxSpot)
+        write(offsetof(Block, m_spotLights) + sizeof(SpotLight) * index, &light, sizeof(SpotLight));
+}
+
+void LightBuffer::write(size_t offset, const void* data, size_t size)
+{
+    unsigned char* target = reinterpret_cast<unsigned char*>(&m_block) + offset;
+    if (std::memcmp(target, data, size) == 0)
+        return;
+
+    std::memcpy(target, data, size);
+
+    // Writes usually come in array order, so extend the last range when they touch
+    if (!m_dirty.empty() && offset <= m_dirty.back().m_end + k_mergeGap && offset >= m_dirty.back().m_begin)
+        m_dirty.back().m_end = std::max(m_dirty.back().m_end, offset + size);
+    else
+        m_dirty.push_back({ offset, offset + size });
+}
+
+// Merge the dirty ranges and send them, then bind the buffer for this frame's draws
+void LightBuffer::upload()
+{
+    m_uploadedBytes = 0;
+    m_uploadCount = 0;
+
+    if (m_buffer == 0)
+        return;
+
+    if (!m_dirty.empty())
+    {
+        std::sort(m_dirty.begin(), m_dirty.end(), [](const Range& a, const Range& b) { return a.m_begin < b.m_begin; });
+
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&m_block);
+
+        size_t i = 0;
+        while (i < m_dirty.size())
+        {
+            Range range = m_dirty[i++];
+            while (i < m_dirty.size() && m_dirty[i].m_begin <= range.m_end + k_mergeGap)
+                range.m_end = std::max(range.m_end, m_dirty[i++].m_end);
+
+            glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(range.m_begin),
+                static_cast<GLsizeiptr>(range.m_end - range.m_begin), bytes + range.m_begin);
+            m_uploadedBytes += range.m_end - range.m_begin;
+            ++m_uploadCount;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        m_dirty.clear();
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, k_bindingPoint, m_buffer);
+}
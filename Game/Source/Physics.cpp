@@ -1,18 +1,16 @@
 #include "Physics/Physics.h"
 
-std::optional<Physics::RaycastHit> Physics::PhysicsManager::Raycast(const LibMath::Line3D& ray, const std::vector<Collider*>& colliders, float maxDistance)
+std::optional<Physics::RaycastHit> Physics::PhysicsManager::Raycast(const LibMath::Line3D& ray, const BroadPhase& colliders, const QueryFilter& filter, float maxDistance)
 {
     std::optional<RaycastHit> closestHit = std::nullopt;
     float currentClosestDistance = maxDistance; // Initialize with max allowed distance
 
-    for (const auto& colliderPtr : colliders)
+    // The broad-phase skips whole layers rejected by the filter
+    colliders.forEach(filter, [&](const Collider& collider)
     {
-        if (colliderPtr == nullptr)
-            continue; // Skip null colliders
-
         // Call the virtual intersect method on each collider
         // This will dispatch to BoxCollider::intersect, SphereCollider::intersect, etc.
-        std::optional<RaycastHit> hit = colliderPtr->intersect(ray, currentClosestDistance);
+        std::optional<RaycastHit> hit = collider.intersect(ray, currentClosestDistance);
 
         if (hit.has_value())
         {
@@ -23,10 +21,10 @@ std::optional<Physics::RaycastHit> Physics::PhysicsManager::Raycast(const LibMat
                 closestHit = hit;
                 // Ensure the collider pointer in the hit struct points to the actual collider
                 // (though it should already be set by the individual intersect methods)
-                closestHit->m_collider = colliderPtr;
+                closestHit->m_collider = &collider;
             }
         }
-    }
+    });
     return closestHit;
 }
 
@@ -36,7 +36,7 @@ void Player::reset()
     m_phone.setState(ColorState::E_INACTIVE);
 }
 
-void Player::handleInput(GLFWwindow* window, float deltaTime, const std::vector<Collider*>& colliders)
+void Player::handleInput(GLFWwindow* window, float deltaTime, const BroadPhase& colliders)
 {
     using namespace LibMath;
 
@@ -167,7 +167,7 @@ void Player::updateCamera()
         m_camera -> setTransform(m_position + Vector3(0, m_height * 0.5, 0) , m_yaw, m_pitch);
 }
 
-void Player::performRaycast(GLFWwindow* window, const std::vector<Collider*>& colliders)
+void Player::performRaycast(GLFWwindow* window, const BroadPhase& colliders)
 {
     // 1. Get camera position and forward direction
     Vector3 origin = m_camera->getPosition();
@@ -179,18 +179,26 @@ void Player::performRaycast(GLFWwindow* window, const std::vector<Collider*>& co
 
     m_activeRay = ray;
 
-    // 3. Perform performRaycast
-    auto hit = Physics::PhysicsManager::Raycast(ray, colliders);
+    // 3. Perform performRaycast against interactables only
+    QueryFilter interactables;
+    interactables.m_include = LAYER_INTERACTABLE;
+    auto hit = Physics::PhysicsManager::Raycast(ray, colliders, interactables);
 
-    if (hit && hit->m_collider != m_collider.get())
+    // 4. Anything solid in front of the target blocks the interaction (doors of the phone colour don't)
+    if (hit)
     {
-        if (hit->m_collider -> getGameObject() -> m_type == GameObjectType::BUTTON || 
-            hit->m_collider -> getGameObject() -> m_type == GameObjectType::MOVING_OBJECT)
-        {
-            m_phone.swapColorState(hit->m_collider -> getGameObject() -> m_colorState);
-            hit->m_collider -> getGameObject() -> setMeshTexture();
-			Audio_Manager::getInstance() -> playSound("../../Assets/Sounds/SFX/Ding.wav", false);
-        }
+        QueryFilter blockers;
+        blockers.m_include = LAYER_OBSTACLE | LAYER_DOOR;
+        blockers.m_exclude = colorLayer(m_phone.getState());
+        if (Physics::PhysicsManager::Raycast(ray, colliders, blockers, hit->m_distance))
+            hit.reset();
+    }
+
+    if (hit)
+    {
+        m_phone.swapColorState(hit->m_collider -> getGameObject() -> m_colorState);
+        hit->m_collider -> getGameObject() -> setMeshTexture();
+		Audio_Manager::getInstance() -> playSound("../../Assets/Sounds/SFX/Ding.wav", false);
     }
     else
     {
@@ -206,4 +214,6 @@ void Player::setCamera(Camera* camera)
 void Player::setCollider(std::unique_ptr<Collider> collider)
 {
     m_collider = std::move(collider);
+    if (m_collider)
+        m_collider -> setLayer(LAYER_PLAYER);
 }
@@ -0,0 +1,175 @@
+#include "Physics/TriggerSystem.h"
+#include "Physics/Collider.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Physics
+{
+    // Overlap test between two axis-aligned boxes
+    static bool overlaps(const LibMath::Prism3DAABB& a, const LibMath::Prism3DAABB& b)
+    {
+        LibMath::Point3D aMin = a.getMin(), aMax = a.getMax();
+        LibMath::Point3D bMin = b.getMin(), bMax = b.getMax();
+        return aMin.getX() <= bMax.getX() && aMax.getX() >= bMin.getX() &&
+               aMin.getY() <= bMax.getY() && aMax.getY() >= bMin.getY() &&
+               aMin.getZ() <= bMax.getZ() && aMax.getZ() >= bMin.getZ();
+    }
+
+    TriggerSystem::TriggerSystem(float cellSize)
+        : m_cellSize(cellSize > 0.0f ? cellSize : 4.0f)
+    {
+    }
+
+    // Pack three 21-bit signed cell coordinates into one key
+    uint64_t TriggerSystem::cellKey(int x, int y, int z) const
+    {
+        const uint64_t mask = (1u << 21) - 1;
+        return (static_cast<uint64_t>(x) & mask) |
+               ((static_cast<uint64_t>(y) & mask) << 21) |
+               ((static_cast<uint64_t>(z) & mask) << 42);
+    }
+
+    void TriggerSystem::cellRange(const LibMath::Prism3DAABB& bounds, int outMin[3], int outMax[3]) const
+    {
+        LibMath::Point3D min = bounds.getMin();
+        LibMath::Point3D max = bounds.getMax();
+        const float lo[3] = { min.getX(), min.getY(), min.getZ() };
+        const float hi[3] = { max.getX(), max.getY(), max.getZ() };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            outMin[axis] = static_cast<int>(std::floor(lo[axis] / m_cellSize));
+            outMax[axis] = static_cast<int>(std::floor(hi[axis] / m_cellSize));
+        }
+    }
+
+    void TriggerSystem::addTrigger(const Collider* trigger, Callback onEnter, Callback onExit, Callback onStay)
+    {
+        if (!trigger)
+            return;
+
+        uint32_t index = static_cast<uint32_t>(m_triggers.size());
+
+        Trigger entry;
+        entry.m_collider = trigger;
+        entry.m_bounds = trigger -> getBounds();
+        entry.m_onEnter = std::move(onEnter);
+        entry.m_onExit = std::move(onExit);
+        entry.m_onStay = std::move(onStay);
+
+        int min[3], max[3];
+        cellRange(entry.m_bounds, min, max);
+        for (int z = min[2]; z <= max[2]; ++z)
+            for (int y = min[1]; y <= max[1]; ++y)
+                for (int x = min[0]; x <= max[0]; ++x)
+                    m_cells[cellKey(x, y, z)].push_back(index);
+
+        m_triggers.push_back(std::move(entry));
+    }
+
+    void TriggerSystem::addBody(const Collider* body)
+    {
+        if (body && std::find(m_bodies.begin(), m_bodies.end(), body) == m_bodies.end())
+            m_bodies.push_back(body);
+    }
+
+    void TriggerSystem::removeBody(const Collider* body)
+    {
+        m_bodies.erase(std::remove(m_bodies.begin(), m_bodies.end(), body), m_bodies.end());
+        m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+            [body](const Pair& pair) { return pair.m_body == body; }), m_active.end());
+    }
+
+    void TriggerSystem::clear()
+    {
+        m_triggers.clear();
+        m_cells.clear();
+        m_bodies.clear();
+        m_active.clear();
+        ++m_generation;
+    }
+
+    void TriggerSystem::update()
+    {
+        if (m_triggers.empty() || m_bodies.empty())
+            return;
+
+        // Gather the pairs overlapping this frame
+        m_current.clear();
+        LibMath::Vector3 normal;
+        for (const Collider* body : m_bodies)
+        {
+            LibMath::Prism3DAABB bounds = body -> getBounds();
+            ++m_visitStamp;
+
+            int min[3], max[3];
+            cellRange(bounds, min, max);
+            for (int z = min[2]; z <= max[2]; ++z)
+                for (int y = min[1]; y <= max[1]; ++y)
+                    for (int x = min[0]; x <= max[0]; ++x)
+                    {
+                        auto cell = m_cells.find(cellKey(x, y, z));
+                        if (cell == m_cells.end())
+                            continue;
+
+                        for (uint32_t index : cell -> second)
+                        {
+                            Trigger& trigger = m_triggers[index];
+                            if (trigger.m_visitStamp == m_visitStamp)
+                                continue;
+                            trigger.m_visitStamp = m_visitStamp;
+
+                            if (overlaps(trigger.m_bounds, bounds) && trigger.m_collider -> checkCollision(*body, normal))
+                                m_current.push_back({ index, body });
+                        }
+                    }
+        }
+        std::sort(m_current.begin(), m_current.end());
+
+        // Diff against last frame: new pairs enter, missing pairs exit, shared pairs stay
+        m_events.clear();
+        auto previous = m_active.begin();
+        auto current = m_current.begin();
+        while (previous != m_active.end() || current != m_current.end())
+        {
+            if (current == m_current.end() || (previous != m_active.end() && *previous < *current))
+            {
+                m_events.push_back({ EventType::EXIT, *previous++ });
+            }
+            else if (previous == m_active.end() || *current < *previous)
+            {
+                m_events.push_back({ EventType::ENTER, *current++ });
+            }
+            else
+            {
+                if (m_triggers[current -> m_trigger].m_onStay)
+                    m_events.push_back({ EventType::STAY, *current });
+                ++previous;
+                ++current;
+            }
+        }
+        m_active.swap(m_current);
+
+        // Dispatch from a local list, callbacks may add triggers or clear the system
+        std::vector<Event> events;
+        events.swap(m_events);
+        uint32_t generation = m_generation;
+        for (const Event& event : events)
+        {
+            if (generation != m_generation)
+                break;
+
+            const Trigger& trigger = m_triggers[event.m_pair.m_trigger];
+            const Callback& callback =
+                event.m_type == EventType::ENTER ? trigger.m_onEnter :
+                event.m_type == EventType::EXIT ? trigger.m_onExit : trigger.m_onStay;
+            if (callback)
+            {
+                // Copy, so the callback outlives a clear() it triggers itself
+                Callback call = callback;
+                call(*trigger.m_collider, *event.m_pair.m_body);
+            }
+        }
+        if (m_events.empty())
+            m_events.swap(events);
+    }
+}
@@ -106,3 +106,22 @@ void UI_Manager::drawMenu(GLFWwindow* window, std::function<void()> onRestartCli
     ImGui::End();
 }
 
+
+void UI_Manager::drawProfiler(std::function<void()> drawContent)
+{
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Always);
+    ImGui::SetNextWindowBgAlpha(0.6f);
+
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing);
+
+    ImGui::Text("%.1f FPS (%.2f ms)", ImGui::GetIO().Framerate, 1000.0f / ImGui::GetIO().Framerate);
+    ImGui::Separator();
+
+    if (drawContent)
+    {
+        drawContent();
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,387 @@
+// Asset cooker.
+//
+// Usage: AssetCooker [--root Assets] [--out Assets/Assets.pak] [--jobs N] [--force] [--verbose]
+// Walks the asset tree and converts every source into the form the game loads:
+//  - meshes (.obj) into .smesh (optimized order, LODs), through Model's own cook path
+//  - textures (.png, .jpg, .tga) into .stex (full mip chain), through Texture::decode
+//  - levels (Levels/*.txt with Levels/lights.txt) into .slvl, with the object bounds of their meshes
+// Cooked files are written next to their source, where the loaders look for them. Shaders, sounds and any
+// other file are packed as they are (the shader program binaries are driver specific, the game caches them).
+// Then everything the game needs, and no source format, is packed into the archive it mounts.
+//
+// Each cooked output is recorded in <out>.deps with the stamps (size, time, content hash) of its inputs and
+// of itself. An output is rebuilt only when one of them changed, the outputs to rebuild are cooked on every
+// core, and the archive is rewritten only when an entry changed.
+
+#include "GameModels.h"
+#include "LevelData.h"
+#include "MappedFile.h"
+#include "Model.h"
+#include "PakArchive.h"
+#include "SourceStamp.h"
+#include "Texture.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef ASSET_COOKER_ASSETS
+#define ASSET_COOKER_ASSETS "../../Assets"
+#endif
+
+namespace
+{
+    constexpr uint32_t k_cookerVersion = 2;     // Bump when a cooked format changes: everything is rebuilt
+
+    enum class StepKind { Mesh, Texture, Level, Copy };
+
+    struct Stamped
+    {
+        std::string m_name;         // Relative to the root, '/' separated
+        SourceStamp m_stamp = {};
+    };
+
+    // What an output was cooked from, as recorded in the dependency file
+    struct Record
+    {
+        SourceStamp             m_output;
+        std::vector<Stamped>    m_inputs;
+    };
+
+    struct Step
+    {
+        StepKind    m_kind = StepKind::Copy;
+        std::string m_source;       // Main input, relative
+        std::string m_output;       // Packed file, relative (the source itself for Copy)
+        Record      m_record = {};
+        bool        m_failed = false;
+    };
+
+    std::string fullPath(const std::filesystem::path& root, const std::string& name)
+    {
+        return (root / name).string();
+    }
+
+    bool stamp(const std::filesystem::path& root, const std::string& name, SourceStamp& outStamp)
+    {
+        MappedFile file;
+        return file.open(fullPath(root, name)) && SourceStamp::make(fullPath(root, name), file.view(), outStamp);
+    }
+
+    bool isCurrent(const std::filesystem::path& root, const std::string& name, const SourceStamp& recorded)
+    {
+        std::error_code ec;
+        return std::filesystem::exists(root / name, ec) && recorded.matches(fullPath(root, name));
+    }
+
+    // --- Dependency file ---
+    // "AssetCooker <version>", then per output: "output <size> <time> <hash> <name>" and its "input" lines
+    // in the same format, and "pak <hash>" for the archive content last written.
+
+    bool readStamp(std::istringstream& line, Stamped& outStamped)
+    {
+        line >> outStamped.m_stamp.m_size >> outStamped.m_stamp.m_time >> outStamped.m_stamp.m_hash;
+        line.get();
+        std::getline(line, outStamped.m_name);
+        return !line.fail() && !outStamped.m_name.empty();
+    }
+
+    void loadRecords(const std::string& path, std::map<std::string, Record>& outRecords, uint64_t& outPakHash)
+    {
+        std::ifstream in(path);
+        std::string text, keyword;
+        uint32_t version = 0;
+        if (!std::getline(in, text) || !(std::istringstream(text) >> keyword >> version) || keyword != "AssetCooker" || version != k_cookerVersion)
+            return;
+
+        Record* current = nullptr;
+        while (std::getline(in, text))
+        {
+            std::istringstream line(text);
+            line >> keyword;
+            Stamped stamped;
+            if (keyword == "output" && readStamp(line, stamped))
+            {
+                current = &outRecords[stamped.m_name];
+                current -> m_output = stamped.m_stamp;
+            }
+            else if (keyword == "input" && current && readStamp(line, stamped))
+                current -> m_inputs.push_back(std::move(stamped));
+            else if (keyword == "pak")
+                line >> outPakHash;
+        }
+    }
+
+    bool saveRecords(const std::string& path, const std::vector<Step>& steps, uint64_t pakHash)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        auto writeStamp = [&](const char* keyword, const std::string& name, const SourceStamp& stamp)
+        {
+            out << keyword << ' ' << stamp.m_size << ' ' << stamp.m_time << ' ' << stamp.m_hash << ' ' << name << '\n';
+        };
+        out << "AssetCooker " << k_cookerVersion << '\n';
+        for (const Step& step : steps)
+        {
+            if (step.m_failed || step.m_kind == StepKind::Copy)
+                continue;
+            writeStamp("output", step.m_output, step.m_record.m_output);
+            for (const Stamped& input : step.m_record.m_inputs)
+                writeStamp("input", input.m_name, input.m_stamp);
+        }
+        out << "pak " << pakHash << '\n';
+        return bool(out);
+    }
+
+    // --- Steps ---
+
+    bool isSkipped(const std::string& name, const std::filesystem::path& path)
+    {
+        const std::string extension = path.extension().string();
+        return name.starts_with("Shaders/Cache/") || name.find(".tmp") != std::string::npos ||
+            extension == ".pak" || extension == ".deps" || extension == ".sprog" ||
+            extension == ".smesh" || extension == ".stex" || extension == ".slvl" ||   // Outputs, found through their source
+            path.filename() == "CMakeLists.txt";
+    }
+
+    bool isLevelDirectory(const std::filesystem::path& path)
+    {
+        return path.parent_path().filename() == "Levels";
+    }
+
+    std::string cookedName(const std::string& source, const char* extension)
+    {
+        return std::filesystem::path(source).replace_extension(extension).generic_string();
+    }
+
+    std::vector<Step> findSteps(const std::filesystem::path& root, std::error_code& ec)
+    {
+        std::vector<Step> steps;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (!it -> is_regular_file())
+                continue;
+            const std::filesystem::path& path = it -> path();
+            std::string name = path.lexically_relative(root).generic_string();
+            if (isSkipped(name, path))
+                continue;
+
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+            Step step{ .m_kind = StepKind::Copy, .m_source = name, .m_output = name };
+            if (extension == ".obj")
+                step = { .m_kind = StepKind::Mesh, .m_source = name, .m_output = cookedName(name, ".smesh") };
+            else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga")
+                step = { .m_kind = StepKind::Texture, .m_source = name, .m_output = cookedName(name, ".stex") };
+            else if (extension == ".txt" && isLevelDirectory(path))
+            {
+                if (path.filename() == "lights.txt")
+                    continue;   // Input of every level next to it
+                step = { .m_kind = StepKind::Level, .m_source = name, .m_output = cookedName(name, ".slvl") };
+            }
+            steps.push_back(std::move(step));
+        }
+        // Directory order differs between systems, the dependency file and the log should not
+        std::sort(steps.begin(), steps.end(), [](const Step& l, const Step& r) { return l.m_source < r.m_source; });
+        return steps;
+    }
+
+    bool isUpToDate(const std::filesystem::path& root, const Step& step, const std::map<std::string, Record>& records)
+    {
+        auto record = records.find(step.m_output);
+        if (record == records.end() || record -> second.m_inputs.empty() || !isCurrent(root, step.m_output, record -> second.m_output))
+            return false;
+        for (const Stamped& input : record -> second.m_inputs)
+            if (!isCurrent(root, input.m_name, input.m_stamp))
+                return false;
+        return true;
+    }
+
+    // Run the game's own loader on the source: on a cache miss it writes the cooked file
+    bool cook(const std::filesystem::path& root, Step& step)
+    {
+        const std::string source = fullPath(root, step.m_source);
+        const std::string output = fullPath(root, step.m_output);
+        std::vector<std::string> inputs = { step.m_source };
+
+        // A stale output would be taken as a valid cache by the loaders
+        std::error_code ec;
+        std::filesystem::remove(output, ec);
+
+        bool cooked = false;
+        switch (step.m_kind)
+        {
+        case StepKind::Mesh:
+        {
+            Model model;
+            cooked = model.loadFromOBJ(source);
+            break;
+        }
+        case StepKind::Texture:
+        {
+            TextureData data;
+            cooked = Texture::decode(source, data);
+            break;
+        }
+        case StepKind::Level:
+        {
+            const std::string lights = (std::filesystem::path(step.m_source).parent_path() / "lights.txt").generic_string();
+            std::vector<std::string> meshes;
+            LevelData level;
+            cooked = level.compile(output, source, fullPath(root, lights), gameModelMeshes(root.string()), &meshes);
+            inputs.push_back(lights);
+            for (const std::string& mesh : meshes)
+                inputs.push_back(std::filesystem::path(mesh).lexically_relative(root).generic_string());
+            break;
+        }
+        case StepKind::Copy:
+            return true;
+        }
+        if (!cooked || !std::filesystem::exists(output, ec))
+        {
+            std::cerr << "Cannot cook " << step.m_source << "\n";
+            return false;
+        }
+
+        step.m_record = {};
+        if (!stamp(root, step.m_output, step.m_record.m_output))
+            return false;
+        for (std::string& input : inputs)
+        {
+            Stamped stamped{ .m_name = std::move(input) };
+            if (!stamp(root, stamped.m_name, stamped.m_stamp))
+                return false;
+            step.m_record.m_inputs.push_back(std::move(stamped));
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path root = ASSET_COOKER_ASSETS;
+    std::string outPath;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--root" && i + 1 < argc)
+            root = argv[++i];
+        else if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--jobs" && i + 1 < argc)
+            jobs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--force")
+            force = true;
+        else if (arg == "--verbose")
+            Model::setVerbose(true);    // What each mesh cook did: reordering, LODs
+        else
+        {
+            std::cerr << "Usage: AssetCooker [--root dir] [--out file.pak] [--jobs N] [--force] [--verbose]\n";
+            return 1;
+        }
+    }
+    if (outPath.empty())
+        outPath = (root / "Assets.pak").string();
+    const std::string depsPath = outPath + ".deps";
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    std::vector<Step> steps = findSteps(root, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot list " << root.string() << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    std::map<std::string, Record> records;
+    uint64_t recordedPakHash = 0;
+    if (!force)
+        loadRecords(depsPath, records, recordedPakHash);
+
+    // 1) Find what changed, keeping the records of the rest
+    std::vector<Step*> dirty;
+    size_t copied = 0;
+    for (Step& step : steps)
+    {
+        if (step.m_kind == StepKind::Copy)
+        {
+            ++copied;
+            continue;
+        }
+        if (isUpToDate(root, step, records))
+            step.m_record = records[step.m_output];
+        else
+            dirty.push_back(&step);
+    }
+
+    // 2) Cook them on every core, one output per task
+    {
+        std::atomic<size_t> next = 0;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < std::min(jobs, dirty.size()); ++t)
+        {
+            workers.emplace_back([&]
+            {
+                for (size_t i = next++; i < dirty.size(); i = next++)
+                {
+                    dirty[i] -> m_failed = !cook(root, *dirty[i]);
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+    const size_t failed = size_t(std::count_if(steps.begin(), steps.end(), [](const Step& step) { return step.m_failed; }));
+
+    // 3) The archive content is identified by the name and content hash of every entry
+    uint64_t pakHash = 0;
+    std::string key;
+    for (const Step& step : steps)
+    {
+        SourceStamp entry = step.m_record.m_output;
+        if (step.m_kind == StepKind::Copy && !stamp(root, step.m_output, entry))
+            return 1;
+        key += step.m_output + '\n' + std::to_string(entry.m_hash) + '\n';
+    }
+    pakHash = SourceStamp::hash(key);
+
+    bool packed = false;
+    if (!failed && (pakHash != recordedPakHash || !std::filesystem::exists(outPath, ec)))
+    {
+        std::vector<MappedFile> files(steps.size());
+        std::vector<PakArchive::Source> sources;
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            if (!files[i].open(fullPath(root, steps[i].m_output)))
+                return 1;
+            // Meshes and levels are used in place from the mapping. Mip chains are copied to the GPU anyway,
+            // inflating them costs little next to their raw size on disk
+            sources.push_back({ steps[i].m_output, files[i].view(), steps[i].m_kind == StepKind::Copy || steps[i].m_kind == StepKind::Texture });
+        }
+        PakArchive::WriteStats stats;
+        if (!PakArchive::write(outPath, sources, &stats))
+            return 1;
+        packed = true;
+        std::cout << outPath << ": " << stats.m_entryCount << " files (" << stats.m_compressedCount << " compressed), "
+            << stats.m_sourceBytes << " -> " << stats.m_archiveBytes << " bytes\n";
+    }
+    saveRecords(depsPath, steps, failed ? recordedPakHash : pakHash);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << steps.size() << " assets: " << dirty.size() - failed << " cooked, " << failed << " failed, "
+        << steps.size() - dirty.size() - copied << " up to date, " << copied << " packed as they are, archive " << (packed ? "written" : failed ? "not written" : "up to date")
+        << " (" << jobs << " jobs, " << ms << " ms)\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+// Level compiler.
+//
+// Usage: LevelCompiler [--level LevelTest.txt] [--lights lights.txt] [--out LevelTest.slvl] [--model name=mesh.obj ...]
+// Parses the text level and lights with LevelData, interns the model and material names, and stores
+// the world matrices, the collider bounds of every object (AABB of its transformed model vertices)
+// and the lights into a .slvl the game maps at startup.
+// Models default to the game's table (Application::loadResources); --model adds or replaces entries.
+
+#include "LevelData.h"
+#include "GameModels.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#ifndef LEVEL_COMPILER_ASSETS
+#define LEVEL_COMPILER_ASSETS "../../Assets"
+#endif
+
+int main(int argc, char** argv)
+{
+    const std::string assets = LEVEL_COMPILER_ASSETS;
+    std::string levelPath = assets + "/Levels/LevelTest.txt";
+    std::string lightsPath = assets + "/Levels/lights.txt";
+    std::string outPath;
+
+    std::map<std::string, std::string, std::less<>> modelPaths = gameModelMeshes(assets);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--level" && i + 1 < argc)
+            levelPath = argv[++i];
+        else if (arg == "--lights" && i + 1 < argc)
+            lightsPath = argv[++i];
+        else if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--model" && i + 1 < argc)
+        {
+            std::string entry = argv[++i];
+            size_t equal = entry.find('=');
+            if (equal == std::string::npos || equal == 0)
+            {
+                std::cerr << "Expected --model name=mesh.obj, got " << entry << "\n";
+                return 1;
+            }
+            modelPaths[entry.substr(0, equal)] = entry.substr(equal + 1);
+        }
+        else
+        {
+            std::cerr << "Usage: LevelCompiler [--level file] [--lights file] [--out file] [--model name=mesh.obj ...]\n";
+            return 1;
+        }
+    }
+    if (outPath.empty())
+        outPath = LevelData::compiledPathFor(levelPath);
+
+    auto start = std::chrono::steady_clock::now();
+
+    LevelData level;
+    if (!level.compile(outPath, levelPath, lightsPath, modelPaths))
+        return 1;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << outPath << ": " << level.getObjects().size() << " objects, " << level.getLights().size() << " lights, "
+        << level.getModels().size() << " models, " << level.getMaterials().size() << " materials (" << ms << " ms)\n";
+    return 0;
+}
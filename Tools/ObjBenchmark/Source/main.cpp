@@ -0,0 +1,152 @@
+// OBJ parsing throughput benchmark.
+//
+// Usage: ObjBenchmark [mesh.obj ...] [--synthetic-mb N] [--runs N]
+// Parses each mesh with Model::parseOBJ (memory mapped + TextTokenizer) and reports MB/s.
+// Two synthetic files of about N MB (default 100) are generated in the working directory:
+// a triangle soup with v/vt/vn faces and a quad grid using negative (relative) indices.
+
+#include "Model.h"
+#include "MappedFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef OBJ_BENCHMARK_DEFAULT_MESH
+#define OBJ_BENCHMARK_DEFAULT_MESH "../../Assets/Meshes/Corridor.obj"
+#endif
+
+namespace
+{
+    // Triangles with full v/vt/vn indices, few shared corners (worst case for the vertex map)
+    void writeTriangleSoup(const std::string& path, size_t targetBytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        char line[160];
+        size_t written = 0;
+        for (size_t i = 1; written < targetBytes; i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                float x = float((i + k) % 1000) * 0.013f, y = float((i + k) % 777) * 0.021f, z = float((i + k) % 313) * -0.017f;
+                written += std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+                    x, y, z, x * 0.1f, y * 0.1f, 0.0f, 1.0f, 0.0f);
+                out << line;
+            }
+            written += std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                i, i, i, i + 1, i + 1, i + 1, i + 2, i + 2, i + 2);
+            out << line;
+        }
+    }
+
+    // Rows of a grid written as quads with relative indices, every inner corner is shared by four faces
+    void writeQuadGrid(const std::string& path, size_t targetBytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        const int width = 512;
+        char line[160];
+        size_t written = 0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            written += std::snprintf(line, sizeof(line), "v %d.0 0.0 0.0\n", x);
+            out << line;
+        }
+        out << "vn 0 1 0\n";
+
+        for (int row = 1; written < targetBytes; ++row)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                written += std::snprintf(line, sizeof(line), "v %d.0 0.0 %d.0\n", x, row);
+                out << line;
+            }
+            // With the new row just written, the previous row starts at -2 * width
+            for (int x = 0; x + 1 < width; ++x)
+            {
+                int a = -2 * width + x, b = a + 1, c = -width + x + 1, d = -width + x;
+                written += std::snprintf(line, sizeof(line), "f %d//-1 %d//-1 %d//-1 %d//-1\n", a, b, c, d);
+                out << line;
+            }
+        }
+    }
+
+    bool benchmark(const std::string& path, int runs)
+    {
+        MappedFile file;
+        if (!file.open(path))
+            return false;
+
+        double megabytes = double(file.size()) / (1024.0 * 1024.0);
+        double best = 1e30, total = 0.0;
+        size_t vertexCount = 0, indexCount = 0;
+
+        for (int run = 0; run < runs; ++run)
+        {
+            std::vector<Vertex>   vertices;
+            std::vector<uint32_t> indices;
+
+            auto start = std::chrono::steady_clock::now();
+            if (!Model::parseOBJ(file.view(), vertices, indices))
+                return false;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            best = std::min(best, seconds);
+            total += seconds;
+            vertexCount = vertices.size();
+            indexCount = indices.size();
+        }
+
+        std::printf("%-40s %8.1f MB  %9zu verts  %9zu tris   best %8.1f MB/s   avg %8.1f MB/s\n",
+            path.c_str(), megabytes, vertexCount, indexCount / 3, megabytes / best, megabytes * runs / total);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> meshes;
+    size_t syntheticMB = 100;
+    int runs = 3;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--synthetic-mb" && i + 1 < argc)
+            syntheticMB = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else
+            meshes.push_back(arg);
+    }
+    if (meshes.empty())
+        meshes.push_back(OBJ_BENCHMARK_DEFAULT_MESH);
+
+    std::vector<std::string> synthetic;
+    if (syntheticMB > 0)
+    {
+        std::cout << "Generating " << syntheticMB << " MB synthetic OBJ files...\n";
+        synthetic = { "synthetic_soup.obj", "synthetic_grid.obj" };
+        writeTriangleSoup(synthetic[0], syntheticMB * 1024 * 1024);
+        writeQuadGrid(synthetic[1], syntheticMB * 1024 * 1024);
+        meshes.insert(meshes.end(), synthetic.begin(), synthetic.end());
+    }
+
+    int result = 0;
+    for (const std::string& mesh : meshes)
+    {
+        if (!benchmark(mesh, runs))
+        {
+            std::cerr << "Failed to benchmark " << mesh << "\n";
+            result = 1;
+        }
+    }
+
+    for (const std::string& path : synthetic)
+        std::remove(path.c_str());
+
+    return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Meshes of the model names a level refers to, the table Application::loadResources registers.
+// Shared by the tools that compile levels (LevelCompiler, AssetCooker); keep both in sync with the game.
+
+#include <map>
+#include <string>
+
+inline std::map<std::string, std::string, std::less<>> gameModelMeshes(const std::string& assets)
+{
+    return {
+        { "floor", assets + "/Meshes/floor.obj" },
+        { "wall",  assets + "/Meshes/wall.obj" },
+        { "cube",  assets + "/Meshes/rounded_cube.obj" },
+        { "door",  assets + "/Meshes/Door.obj" },
+        { "oCube", assets + "/Meshes/1x1x1cube.obj" },
+    };
+}